@@ -56,14 +56,7 @@ class AlignedBuffer {
   [[nodiscard]] inline unsigned char const* data() const& noexcept { return data_; }
   [[nodiscard]] inline std::size_t size() const noexcept { return size_; }
 
-  [[nodiscard]] inline bool isZero() const noexcept {
-    for (std::size_t i = 0; i < size_; ++i) {
-      if (data_[i]) {
-        return false;
-      }
-    }
-    return true;
-  }
+  [[nodiscard]] inline bool isZero() const noexcept { return IsZero(data_, size_); }
 
   [[nodiscard]] inline friend bool operator==(AlignedBuffer const& a,
                                               AlignedBuffer const& b) noexcept {
@@ -74,12 +67,7 @@ class AlignedBuffer {
       assert(std::addressof(a) == std::addressof(b));
       return true;
     }
-    for (std::size_t i = 0; i < a.size_; ++i) {
-      if (a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return Equal(a.data(), b.data(), a.size_);
   }
 
   [[nodiscard]] inline friend bool operator!=(AlignedBuffer const& a,
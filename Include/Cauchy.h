@@ -0,0 +1,184 @@
+/*********************************************************
+ * Cauchy.h  - header file for a Cauchy Reed-Solomon based RAID
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#ifndef CAUCHY_H
+#define CAUCHY_H
+
+#include <atomic>
+#include <map>
+#include <vector>
+#include "RAIDProcessor.h"
+#include "arithmetic.h"
+#include "sync.h"
+
+///a sequence of XOR operations computing some packets from the other ones.
+///The packets are numbered as follows: NumOfInputs input packets, then NumOfTemps temporary packets,
+///then the output packets
+struct XORSchedule
+{
+    ///the number of input packets
+    unsigned NumOfInputs;
+    ///the number of temporary packets
+    unsigned NumOfTemps;
+    ///step i computes packet Dest[i] as the sum of packets Sources[Start[i]..Start[i+1])
+    std::vector<unsigned> Dest;
+    std::vector<unsigned> Start;
+    std::vector<unsigned> Sources;
+};
+
+///implements a systematic Cauchy Reed-Solomon code over GF(2^8), which is processed using XOR only.
+///Each stripe unit is split into 8 packets, and each GF(2^8) coefficient of the Cauchy matrix
+///is replaced with the 8x8 binary matrix of multiplication by it. The XOR schedules
+///are optimized by common subexpression elimination
+class CCauchyProcessor:public CRAIDProcessor
+{
+    ///the number of check symbols
+    unsigned m_Redundancy;
+    ///the size of a packet, i.e. 1/8 of a stripe unit
+    unsigned m_PacketSize;
+    ///m_Redundancy x m_Dimension Cauchy matrix. The first row and the number of ones
+    ///in the binary matrices of the other rows are optimized by scaling
+    GFValue* m_pCauchyMatrix;
+    ///the binary matrix of the code: entry (8i+r, 8j+c) is 1 if packet c of information symbol j
+    ///contributes to packet r of check symbol i
+    unsigned char* m_pBitMatrix;
+    ///the schedule computing the check symbols from the information ones
+    XORSchedule m_EncodingSchedule;
+
+    ///the recovery of erased information symbols for an erasure pattern
+    struct DecodingPlan
+    {
+        ///m_Dimension surviving symbols used for recovery
+        std::vector<unsigned> Sources;
+        ///the erased information symbols in ascending order
+        std::vector<unsigned> Targets;
+        ///the binary rows expressing the target packets via the source ones.
+        ///They are consumed when the schedule is built
+        std::vector<std::vector<unsigned> > Rows;
+        ///the schedule computing the targets from the sources
+        XORSchedule Schedule;
+        ///true if Schedule has been built
+        std::atomic<bool> Ready;
+        DecodingPlan():Ready(false)
+        {
+        };
+    };
+    ///the plans keyed by the sorted erased positions. They are shared by all erasure sets with
+    ///the same erasure pattern, and are kept if the set of failed disks changes
+    std::map<std::vector<unsigned>,DecodingPlan> m_DecodingPlans;
+    ///the plan used by each erasure set, or 0 if no information symbols are erased
+    DecodingPlan** m_ppDecodingPlans;
+    ///serializes the construction of the decoding schedules
+    tCriticalSection m_PlanLock;
+
+    ///buffer for fetching the codeword symbols. Each thread gets m_Length stripe units
+    unsigned char* m_pSymbols;
+    ///temporary packets of the XOR schedules. Each thread gets m_Dimension stripe units
+    unsigned char* m_pTemps;
+    ///pointers to the XOR sources. Each thread gets 16*m_Length entries
+    const unsigned char** m_ppXORSources;
+
+    ///construct the binary matrix of multiplication by a GF(2^8) element
+    ///@return the number of ones
+    static unsigned GetBitMatrix(GFValue x,///the element
+                                 unsigned char* pMatrix ///8x8 matrix, row-major
+                                );
+    ///convert binary matrix rows into an XOR schedule, extracting common pairs of sources
+    static void BuildSchedule(std::vector<std::vector<unsigned> >& Rows,///sources of each output packet. They are destroyed
+                              unsigned NumOfInputs,///the number of input packets
+                              unsigned MaxTemps,///the maximal number of temporary packets
+                              XORSchedule& Schedule///receives the schedule
+                             );
+    ///build the schedule of a decoding plan on its first use. The common subexpression elimination
+    ///is too slow to be done at mount time for every erasure pattern
+    ///@return the schedule
+    const XORSchedule& GetDecodingSchedule(DecodingPlan& Plan///the plan
+                                          );
+    ///execute an XOR schedule
+    void RunSchedule(const XORSchedule& Schedule,///the schedule
+                     const unsigned char* const* ppInputs,///input stripe units, 8 packets each
+                     unsigned char* const* ppOutputs,///output stripe units, 8 packets each
+                     size_t ThreadID ///the ID of the calling thread
+                    );
+protected:
+    ///Check if it is possible to correct a given combination of erasures
+    ///If yes, the method should initialize the internal data structures
+    ///and be ready to do the actual erasure correction. This combination of erasures
+    /// is uniquely identified by ErasureID
+    ///@return true if the specified combination of erasures is correctable
+    virtual bool IsCorrectable(unsigned ErasureSetID///identifies the erasure combination. This will not exceed m_Length-1
+                              );
+    ///reset the erasure correction engine
+    /// this will be called if the set of failed disks changes
+    virtual void ResetErasures();
+    ///This is a stub which should never be called
+    virtual bool DecodeDataSubsymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the symbol to be processed
+                                  unsigned SubsymbolID,///the first subsymbol to be processed
+                                  unsigned Subsymbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 )
+    {
+        return false;
+    };
+    ///decode a number of payload subsymbols from a given symbol
+    ///@return true on success
+    virtual bool DecodeDataSymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the first symbol to be processed
+                                  unsigned Symbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 );
+    ///count the stripe units read by DecodeDataSymbols: the requested surviving symbols
+    ///and the recovery sources outside of the requested range
+    ///@return the number of stripe units to be read
+    virtual unsigned GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                 unsigned StripeUnitID,///the first stripe unit to be read
+                                 unsigned NumOfUnits,///the number of units to be read
+                                 size_t ThreadID ///the ID of the calling thread
+                 );
+    ///encode and write the whole stripe
+    ///@return true on success
+    virtual bool EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
+                              unsigned ErasureSetID,///identifies the load balancing offset
+                              const unsigned char* pData,///the data to be envoced
+                              size_t ThreadID ///the ID of the calling thread
+                 );
+    ///update some information symbols and the corresponding check symbols
+    ///@return true on success
+    virtual bool UpdateInformationSymbols(unsigned long long StripeID,///the stripe to be updated,
+                                          unsigned ErasureSetID,///identifies the load balancing offset
+                                          unsigned StripeUnitID,///the first stripe unit to be updated
+                                          unsigned Units2Update,///the number of units to be updated
+                                          const unsigned char* pData,///new payload data symbols
+                                          size_t ThreadID ///the ID of the calling thread
+                 );
+    ///check if the codeword is consistent
+    virtual bool CheckCodeword(unsigned long long StripeID,///the stripe to be checked
+                               unsigned ErasureSetID,///identifies the load balancing offset
+                               size_t ThreadID ///identifies the calling thread
+                              );
+
+public:
+    ///initialize coding-related parameters
+    CCauchyProcessor(CauchyParams* P ///the configuration file
+                    );
+    ~CCauchyProcessor();
+    ///attach to the disk array
+    ///Prepare for multi-threaded processing
+    ///@return true on success
+    virtual bool Attach(CDiskArray* pArray,///the disk array
+                        unsigned ConcurrentThreads ///the number of concurrent processing threads that will make calls to the processor
+                       );
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*********************************************************
+ * LRC.h  - header file for a local reconstruction code based RAID
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#ifndef LRC_H
+#define LRC_H
+
+#include <vector>
+#include "RAIDProcessor.h"
+#include "arithmetic.h"
+
+///implements a local reconstruction code over GF(2^8).
+///The information symbols are split into groups of GroupSize symbols, and each group is protected
+///by a local parity symbol, which is the XOR of the group. The whole stripe is protected
+///by GlobalRedundancy check symbols given by a Cauchy matrix. The codeword consists of the
+///information symbols, the local parities in the group order, and the global parities.
+///A single erasure within a group is recovered from this group only
+class CLRCProcessor:public CRAIDProcessor
+{
+    ///the number of information symbols in a local group
+    unsigned m_GroupSize;
+    ///the number of local groups
+    unsigned m_NumOfGroups;
+    ///the number of global check symbols
+    unsigned m_GlobalRedundancy;
+    ///m_GlobalRedundancy x m_Dimension matrix of global check symbol coefficients (logarithms)
+    int* m_pGlobalCoefficients;
+
+    ///the recovery of erased information symbols for an erasure set
+    struct RecoveryPlan
+    {
+        ///the number of erased symbols in each local group, including its local parity
+        std::vector<unsigned> GroupErasures;
+        ///m_Dimension surviving symbols used to recover the symbols which cannot be recovered locally
+        std::vector<unsigned> Sources;
+        ///the erased information symbols which cannot be recovered locally, in ascending order
+        std::vector<unsigned> Targets;
+        ///Targets.size() x m_Dimension matrix expressing the targets via the sources (logarithms)
+        std::vector<int> Coefficients;
+    };
+    ///the plan for each erasure set
+    RecoveryPlan* m_pPlans;
+
+    ///buffer for fetching the codeword symbols. Each thread gets m_Length stripe units
+    unsigned char* m_pSymbols;
+    ///buffer for the global check symbols. Each thread gets m_GlobalRedundancy stripe units
+    unsigned char* m_pParities;
+    ///per-thread coefficients used by UpdateInformationSymbols. Each thread gets m_GlobalRedundancy*m_Length entries
+    int* m_pUpdateCoefficients;
+
+    ///@return the local group of an information symbol
+    unsigned GetGroup(unsigned SymbolID)const
+    {
+        return SymbolID/m_GroupSize;
+    };
+    ///@return the number of information symbols in a local group
+    unsigned GetGroupLength(unsigned GroupID)const
+    {
+        return (GroupID+1<m_NumOfGroups)?m_GroupSize:m_Dimension-GroupID*m_GroupSize;
+    };
+    ///@return true if an erased information symbol is recovered from its local group
+    bool IsLocallyRecoverable(unsigned ErasureSetID,///identifies the erasure combination
+                              unsigned SymbolID ///the symbol
+                             )const
+    {
+        return m_pPlans[ErasureSetID].GroupErasures[GetGroup(SymbolID)]==1;
+    };
+    ///mark the symbols which must be fetched in order to recover the erased information symbols
+    ///within a given range
+    void GetRecoverySources(unsigned ErasureSetID,///identifies the erasure combination
+                            unsigned SymbolID,///the first symbol to be recovered
+                            unsigned NumOfSymbols,///the number of symbols
+                            bool* pNeeded ///m_Length flags, which are set for the needed symbols
+                           )const;
+protected:
+    ///Check if it is possible to correct a given combination of erasures
+    ///If yes, the method should initialize the internal data structures
+    ///and be ready to do the actual erasure correction. This combination of erasures
+    /// is uniquely identified by ErasureID
+    ///@return true if the specified combination of erasures is correctable
+    virtual bool IsCorrectable(unsigned ErasureSetID///identifies the erasure combination. This will not exceed m_Length-1
+                              );
+    ///This is a stub which should never be called
+    virtual bool DecodeDataSubsymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the symbol to be processed
+                                  unsigned SubsymbolID,///the first subsymbol to be processed
+                                  unsigned Subsymbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 )
+    {
+        return false;
+    };
+    ///decode a number of payload subsymbols from a given symbol
+    ///@return true on success
+    virtual bool DecodeDataSymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the first symbol to be processed
+                                  unsigned Symbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 );
+    ///count the stripe units read by DecodeDataSymbols: the requested surviving symbols,
+    ///and the local groups or the global recovery sources of the requested erased ones
+    ///@return the number of stripe units to be read
+    virtual unsigned GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                 unsigned StripeUnitID,///the first stripe unit to be read
+                                 unsigned NumOfUnits,///the number of units to be read
+                                 size_t ThreadID ///the ID of the calling thread
+                 );
+    ///count the stripe units transferred by UpdateInformationSymbols. Only the local parities
+    ///of the affected groups and the global parities are updated
+    ///@return false if UpdateInformationSymbols cannot handle this request
+    virtual bool GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                               unsigned StripeUnitID,///the first stripe unit to be updated
+                               unsigned Units2Update,///the number of units to be updated
+                               IOCost& Cost,///receives the cost
+                               size_t ThreadID ///the ID of the calling thread
+                 );
+    ///encode and write the whole stripe
+    ///@return true on success
+    virtual bool EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
+                              unsigned ErasureSetID,///identifies the load balancing offset
+                              const unsigned char* pData,///the data to be envoced
+                              size_t ThreadID ///the ID of the calling thread
+                 );
+    ///update some information symbols and the corresponding check symbols
+    ///@return true on success
+    virtual bool UpdateInformationSymbols(unsigned long long StripeID,///the stripe to be updated,
+                                          unsigned ErasureSetID,///identifies the load balancing offset
+                                          unsigned StripeUnitID,///the first stripe unit to be updated
+                                          unsigned Units2Update,///the number of units to be updated
+                                          const unsigned char* pData,///new payload data symbols
+                                          size_t ThreadID ///the ID of the calling thread
+                 );
+    ///check if the codeword is consistent
+    virtual bool CheckCodeword(unsigned long long StripeID,///the stripe to be checked
+                               unsigned ErasureSetID,///identifies the load balancing offset
+                               size_t ThreadID ///identifies the calling thread
+                              );
+
+public:
+    ///initialize coding-related parameters
+    CLRCProcessor(LRCParams* P ///the configuration file
+                 );
+    ~CLRCProcessor();
+    ///attach to the disk array
+    ///Prepare for multi-threaded processing
+    ///@return true on success
+    virtual bool Attach(CDiskArray* pArray,///the disk array
+                        unsigned ConcurrentThreads ///the number of concurrent processing threads that will make calls to the processor
+                       );
+};
+
+#endif
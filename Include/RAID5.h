@@ -25,8 +25,10 @@ struct RAID5Params:public RAIDParams
 
 class CRAID5Processor:public CRAIDProcessor
 {
-    ///the buffer used for parity computation
+    ///the buffer used for parity computation. Each thread gets m_Length stripe units
     unsigned char* m_pXORBuffer;
+    ///the arrays of pointers to the symbols being XORed. Each thread gets 2*m_Length entries
+    const unsigned char** m_ppXORSources;
 protected:
       ///Check if it is possible to correct a given combination of erasures
     ///If yes, the method should initialize the internal data structures
@@ -81,6 +83,14 @@ protected:
                                           const unsigned char* pData,///new payload data symbols
                                           size_t ThreadID ///the ID of the calling thread
                  );
+    ///count the stripe units transferred by UpdateInformationSymbols
+    ///@return true, since any update can be performed
+    virtual bool GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                               unsigned StripeUnitID,///the first stripe unit to be updated
+                               unsigned Units2Update,///the number of units to be updated
+                               IOCost& Cost,///receives the cost
+                               size_t ThreadID ///the ID of the calling thread
+                 );
     ///make sure that the codeword is a legal one
     ///@return true on success
     bool CheckCodeword(unsigned long long StripeID,///identifies the codeword to be validated
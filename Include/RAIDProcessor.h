@@ -145,15 +145,69 @@ protected:
                                   unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
                                   size_t ThreadID ///the ID of the calling thread
                                  )=0;
-    ///make a decision about the optimal data encoding method
-    ///@return true if one should fetch all the data from disk, update it and write back. Otherwise, only check symbols will be updated
-    virtual bool GetEncodingStrategy(unsigned ErasureSetID,///identifies the load balancing offset
-                                     unsigned StripeUnitID,///the first stripe unit to be updated
-                                    unsigned Subsymbols2Encode ///the number of subsymbols to be encoded
-                 )
+    ///the ways of writing some payload stripe units
+    enum eEncodingStrategy
     {
-        return (Subsymbols2Encode>2*m_Dimension*m_StripeUnitsPerSymbol/3);
+        ///read the old values of the affected data and check units, and update them (UpdateInformationSymbols)
+        esReadModifyWrite,
+        ///read the unaffected data units, decoding them if needed, and re-encode the stripe
+        esReconstructWrite,
+        ///the whole stripe is overwritten, so it is just encoded
+        esFullStripe
     };
+    ///the number of stripe units transferred by some operation
+    struct IOCost
+    {
+        unsigned Reads;
+        unsigned Writes;
+        unsigned Total()const
+        {
+            return Reads+Writes;
+        };
+    };
+    ///count the stripe units read from the disks by ReadData
+    ///The default implementation assumes that the decoder reads all surviving symbols
+    ///if some of the requested units reside on erased disks
+    ///@return the number of stripe units to be read
+    virtual unsigned GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                 unsigned StripeUnitID,///the first stripe unit to be read
+                                 unsigned NumOfUnits,///the number of units to be read
+                                 size_t ThreadID ///the ID of the calling thread
+                 );
+    ///count the symbols read by a decoder, which fetches the requested surviving symbols, and a fixed
+    ///set of recovery sources if some of the requested symbols are erased.
+    ///For the codes with a single stripe unit per symbol, this is the number of stripe units
+    ///@return the number of symbols to be read
+    unsigned GetRecoveryReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                 unsigned SymbolID,///the first requested symbol
+                                 unsigned NumOfSymbols,///the number of requested symbols
+                                 const unsigned* pSources,///the surviving symbols used for recovery
+                                 unsigned NumOfSources///the number of recovery sources
+                                )const;
+    ///count the stripe units transferred by UpdateInformationSymbols for the current erasure set
+    ///The default implementation assumes that each non-erased check symbol has to be read and written
+    ///at up to m_StripeUnitsPerSymbol positions, and that erased data symbols cannot be updated
+    ///@return false if UpdateInformationSymbols cannot handle this request
+    virtual bool GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                               unsigned StripeUnitID,///the first stripe unit to be updated
+                               unsigned Units2Update,///the number of units to be updated
+                               IOCost& Cost,///receives the cost
+                               size_t ThreadID ///the ID of the calling thread
+                 );
+    ///count the stripe units transferred if the unaffected data is fetched and the stripe is re-encoded
+    IOCost GetReconstructWriteCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                   unsigned StripeUnitID,///the first stripe unit to be updated
+                                   unsigned Subsymbols2Encode,///the number of subsymbols to be encoded
+                                   size_t ThreadID ///the ID of the calling thread
+                 );
+    ///make a decision about the optimal data encoding method
+    ///The default implementation selects the strategy with the smallest number of disk accesses
+    ///@return the strategy to be used by WriteData
+    virtual eEncodingStrategy GetEncodingStrategy(unsigned ErasureSetID,///identifies the load balancing offset
+                                     unsigned StripeUnitID,///the first stripe unit to be updated
+                                    unsigned Subsymbols2Encode,///the number of subsymbols to be encoded
+                                    size_t ThreadID ///the ID of the calling thread
+                 );
     ///encode and write the whole CRAIDProcessorstripe
     ///@return true on success
     virtual bool EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
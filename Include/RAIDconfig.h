@@ -195,18 +195,21 @@ struct cfg_t;
 #pragma pack(push) 
 #pragma pack(1) 
 #ifdef STUDENTBUILD
-RAIDLIST(3,
+RAIDLIST(5,
     RAID(RAID5,0),
     RAID(RS,1,unsigned,Redundancy),
-    RAID(RTP,0)
+    RAID(RTP,0),
+    RAID(Cauchy,1,unsigned,Redundancy),
+    RAID(LRC,2,unsigned,GroupSize,unsigned,GlobalRedundancy)
     )
 #else
-RAIDLIST(5,
+RAIDLIST(6,
     RAID(RAID5,0),
     RAID(RAID6,0),
     RAID(Cauchy,1,unsigned,Redundancy),
     RAID(RS,3,unsigned,Redundancy,bool,CyclotomicProcessing,bool,OptimizedCheckLocators),
-    RAID(RDP,1,unsigned,PrimeNumber)
+    RAID(RDP,1,unsigned,PrimeNumber),
+    RAID(LRC,2,unsigned,GroupSize,unsigned,GlobalRedundancy)
     )
 #endif
 #pragma pack(pop)
@@ -37,29 +37,47 @@ class CRSProcessor:public CRAIDProcessor
 
     //true if cyclotomic processing is used
     bool m_CyclotomicProcessing;
-    ///temporary array for cyclotomic processing
-    GFValue* m_pCyclotomicTemp;
     //true if the check symbol locators are optimized ones
     bool m_OptimizedCheckLocators;
 
-	///the check symbol locator polynomial
-	GFValue* m_pCheckLocator;
-    ///values of \alpha^{1-b}/\Lambda'(1/X_i) (needed by Forney algorithm)
-    ///where X_i are locators of check symbols
-    int* m_pCheckLocatorsPrime;
-	///syndromes for each stripe unit
+    ///r x k systematic encoding matrix: check symbol i is \sum_j y_j\alpha^{m_pParityCoefficients[i*k+j]},
+    ///where y_j is the j-th information symbol. Negative values stand for zero
+    int* m_pParityCoefficients;
+	///syndromes for each stripe unit, and the new check symbols
 	GFValue* m_pSyndromes;
-	///the erasure evaluator polynomial
-	GFValue* m_pErasureEvaluator;
-	///the erasure locator polynomial for each erasure configuration
-	GFValue* m_pErasureLocators;
-    ///values of \alpha^{1-b}/\Lambda'(1/X_i) (needed by Forney algorithm)
-    ///where X_i are locators of erased symbols
-    int* m_pErasureLocatorsPrime;
+    ///coefficients of the check symbol update for each thread (m_Redundancy x m_Length)
+    int* m_pUpdateCoefficients;
+    ///for each erasure configuration, the m_Dimension surviving symbols used to recover the erased ones
+    unsigned* m_pRecoverySources;
+    ///for each erasure configuration, the erased information symbols in ascending order (m_Redundancy entries)
+    unsigned* m_pRecoveryTargets;
+    ///the number of erased information symbols in each erasure configuration
+    unsigned* m_pNumOfRecoveryTargets;
+    ///for each erasure configuration, m_Redundancy x k matrix expressing the recovery targets
+    ///via the recovery sources, as in m_pParityCoefficients
+    int* m_pRecoveryCoefficients;
 	///buffer for fetching the codeword symbols
 	GFValue* m_pSymbols;
-	///pointers to the fetched symbols
+	///pointers to the fetched symbols, indexed by their locators. Each thread gets RSLength entries
 	const GFValue ** m_ppSymbols;
+	///dense lists of DotProduct sources. Each thread gets m_Length entries
+	const GFValue ** m_ppSources;
+
+    ///@return the locator (log) of a codeword symbol
+    int GetLocator(unsigned DiskID ///the symbol index, as used by CRAIDProcessor
+                  )const
+    {
+        return (DiskID<m_Dimension)?m_pInfSymbols[DiskID]:m_pCheckSymbols[DiskID-m_Dimension];
+    };
+    ///express some codeword symbols as linear combinations of k other ones:
+    ///y_{pTargets[i]}=\sum_j y_{pSources[j]}\alpha^{pCoefficients[i*k+j]}.
+    ///The coefficients are obtained by erasure decoding of all symbols except the sources,
+    ///with the sources set to the unit vectors
+    void GetRecoveryCoefficients(const unsigned* pSources,///k symbol indices
+                                 const unsigned* pTargets,///symbol indices to be expressed
+                                 unsigned NumOfTargets,///the number of targets
+                                 int* pCoefficients///NumOfTargets x k matrix. Negative values stand for zero
+                                );
 		 
 protected:
 	///attach to the disk array
@@ -99,6 +117,14 @@ protected:
                                   unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
                                   size_t ThreadID ///the ID of the calling thread
                                  );
+    ///count the stripe units read by DecodeDataSymbols: the requested surviving symbols
+    ///and the recovery sources outside of the requested range
+    ///@return the number of stripe units to be read
+    virtual unsigned GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                 unsigned StripeUnitID,///the first stripe unit to be read
+                                 unsigned NumOfUnits,///the number of units to be read
+                                 size_t ThreadID ///the ID of the calling thread
+                 );
     ///encode and write the whole stripe
     ///@return true on success
     virtual bool EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
@@ -120,12 +146,6 @@ protected:
                                unsigned ErasureSetID,///identifies the load balancing offset
                                size_t ThreadID ///identifies the calling thread
                               );
-    ///make a decision about the optimal data encoding method
-    ///@return true if one should fetch all the data from disk, update it and write back. Otherwise, only check symbols will be updated
-    virtual bool GetEncodingStrategy(unsigned ErasureSetID,///identifies the load balancing offset
-                                     unsigned StripeUnitID,///the first stripe unit to be updated
-                                    unsigned Subsymbols2Encode ///the number of subsymbols to be encoded
-                 );
 
 public:
     CRSProcessor( RSParams* pParams);
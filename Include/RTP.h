@@ -1,6 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cassert>
+#include <map>
+#include <utility>
+#include <vector>
 #include "AlignedBuffer.h"
 #include "RAIDProcessor.h"
 
@@ -12,19 +16,59 @@ class CRTPProcessor : public CRAIDProcessor {
 
   ~CRTPProcessor() override = default;
 
+  /// the ways to solve the triple erasure equations
+  enum class TripleDecoding {
+    /// the closed form of RestoreMiddleSymbol
+    kClosedForm,
+    /// the Gaussian elimination plans
+    kGaussian,
+    /// both of them, comparing the results
+    kSelfCheck,
+  };
+
+  /// select the triple erasure decoder of the processors created afterwards
+  static void SetTripleDecoding(TripleDecoding Mode) noexcept;
+
+  ///@return the smallest prime p such that p-1 >= Dimension. If p-1 > Dimension,
+  /// the code is shortened: data symbols Dimension..p-2 are zero and are not stored
+  [[nodiscard]] static unsigned GetPrime(unsigned Dimension);
+
+  /// attach to the disk array
+  /// Prepare for multi-threaded processing
+  ///@return true on success
+  bool Attach(CDiskArray* pArray,        /// the disk array
+              unsigned ConcurrentThreads  /// the number of concurrent processing threads
+              ) override;
+
  protected:
+  /// Symbols are numbered as in the unshortened code: data symbols 0..p-2, of which
+  /// m_Dimension..p-2 are virtual, row parity p-1, diagonal parity p and anti-diagonal parity p+1
   unsigned const p;
 
+  ///@return true if the symbol is an implicit zero symbol of a shortened code
+  [[nodiscard]] inline bool IsVirtual(unsigned SymbolID) const noexcept {
+    return m_Dimension <= SymbolID && SymbolID < p - 1;
+  }
+
+  ///@return the position of a stored symbol in the codeword, as used by CRAIDProcessor
+  [[nodiscard]] inline unsigned SymbolDisk(unsigned SymbolID) const noexcept {
+    assert(!IsVirtual(SymbolID));
+    return (SymbolID < p - 1) ? SymbolID : SymbolID - (p - 1) + m_Dimension;
+  }
+
+  ///@return true if the symbol is erased. Virtual symbols never are
+  [[nodiscard]] inline bool IsSymbolErased(unsigned ErasureSetID, unsigned SymbolID) const {
+    return !IsVirtual(SymbolID) && IsErased(ErasureSetID, SymbolDisk(SymbolID));
+  }
+
   /// Check if it is possible to correct a given combination of erasures
   /// If yes, the method should initialize the internal data structures
   /// and be ready to do the actual erasure correction. This combination of erasures
   ///  is uniquely identified by ErasureID
   ///@return true if the specified combination of erasures is correctable
-  inline bool IsCorrectable(
+  bool IsCorrectable(
       unsigned ErasureSetID  /// identifies the erasure combination. This will not exceed m_Length-1
-      ) override {
-    return GetNumOfErasures(ErasureSetID) <= 3;
-  }
+      ) override;
 
   /// decode a number of payload subsymbols from a given symbol
   ///@return true on success
@@ -76,20 +120,28 @@ class CRTPProcessor : public CRAIDProcessor {
                      size_t ThreadID               /// identifies the calling thread
                      ) override;
 
-  bool GetEncodingStrategy(unsigned int ErasureSetID,
-                           unsigned int StripeUnitID,
-                           unsigned int Subsymbols2Encode) override;
+  /// count the stripe units read by ReadData using the decoders of this class
+  unsigned GetReadCost(unsigned ErasureSetID,  /// identifies the load balancing offset
+                       unsigned StripeUnitID,  /// the first stripe unit to be read
+                       unsigned NumOfUnits,    /// the number of units to be read
+                       size_t ThreadID         /// the ID of the calling thread
+                       ) override;
+
+  /// count the stripe units transferred by UpdateInformationSymbols, including
+  /// the decoding of the old contents of erased target symbols
+  ///@return true, since any update can be performed
+  bool GetUpdateCost(unsigned ErasureSetID,  /// identifies the load balancing offset
+                     unsigned StripeUnitID,  /// the first stripe unit to be updated
+                     unsigned Units2Update,  /// the number of units to be updated
+                     IOCost& Cost,           /// receives the cost
+                     size_t ThreadID         /// the ID of the calling thread
+                     ) override;
 
  private:
   [[nodiscard]] inline size_t SymbolSize() const noexcept {
     return m_StripeUnitsPerSymbol * m_StripeUnitSize;
   }
 
-  [[nodiscard]] bool ReadSymbol(unsigned long long StripeID,  /// the stripe to be checked
-                                unsigned ErasureSetID,  /// identifies the load balancing offset,
-                                unsigned SymbolID,      /// identifies the disk to be accessed
-                                AlignedBuffer& out);
-
   [[nodiscard]] bool ReadSymbol(unsigned long long StripeID,  /// the stripe to be checked
                                 unsigned ErasureSetID,  /// identifies the load balancing offset,
                                 unsigned SymbolID,      /// identifies the disk to be accessed
@@ -106,7 +158,7 @@ class CRTPProcessor : public CRAIDProcessor {
   [[nodiscard]] bool WriteSymbol(unsigned long long StripeID,  /// the stripe to be checked
                                  unsigned ErasureSetID,  /// identifies the load balancing offset,
                                  unsigned SymbolID,      /// identifies the disk to be accessed
-                                 AlignedBuffer const& symbol);
+                                 unsigned char const* symbol);
 
   [[nodiscard]] bool WriteSubsymbols(unsigned long long int StripeID,
                                      unsigned int ErasureSetID,
@@ -125,15 +177,171 @@ class CRTPProcessor : public CRAIDProcessor {
     }
   }
 
-  void AddToDiag(AlignedBuffer& diag,
+  /// add the subsymbols of a symbol to the p diagonal sums
+  void AddToDiag(unsigned char* diag,
                  bool isAnti,
                  std::size_t symbolId,
-                 AlignedBuffer const& symbol) const;
+                 unsigned char const* symbol) const;
+
+  /// compute the unstored diagonal sum from the p-1 stored ones,
+  /// placing it after them in the same buffer
+  void RestoreMissingDiag(unsigned char* diag, unsigned char const** sources) const;
+
+  /// add a symbol to the row, diagonal and anti-diagonal sums in a single pass,
+  /// so that each subsymbol is loaded once. row may be null.
+  /// The diagonal sums must have room for p stripe units
+  void AddToChains(unsigned char* row,
+                   unsigned char* diag,
+                   unsigned char* adiag,
+                   std::size_t symbolId,
+                   unsigned char const* symbol) const;
 
-  void AddToDiags(AlignedBuffer& diag,
-                  AlignedBuffer& adiag,
-                  std::size_t symbolId,
-                  AlignedBuffer const& symbol) const;
+  /// mark the row, diagonal and anti-diagonal parity units affected by an update of
+  /// Units2Update data units starting from StripeUnitID. Checksum c is stored on disk p-1+c,
+  /// and its units are marked in touched[c*(p-1)..(c+1)*(p-1))
+  void MarkTouchedUnits(unsigned StripeUnitID, unsigned Units2Update, unsigned char* touched) const;
+
+  ///@return an upper bound on the number of stripe units read by DecodeDataSubsymbols
+  [[nodiscard]] unsigned GetSubsymbolDecodingCost(unsigned ErasureSetID,
+                                                  unsigned SymbolID,
+                                                  unsigned Subsymbols2Decode) const;
+
+  /// contents of the virtual symbols
+  AlignedBuffer m_ZeroSymbol;
+
+  /// the decoder selected by SetTripleDecoding
+  static TripleDecoding s_TripleDecoding;
+  /// the triple erasure decoder of this processor
+  TripleDecoding const m_TripleDecoding;
+
+  /// byte offsets of the diagonal and anti-diagonal sums containing each subsymbol,
+  /// indexed by symbolId*m_StripeUnitsPerSymbol+subsymbolId for symbolId<p
+  std::vector<std::size_t> m_DiagOffsets;
+  std::vector<std::size_t> m_AntiDiagOffsets;
+  /// diagonal and anti-diagonal numbers of each subsymbol, indexed in the same way.
+  /// They spare the per-subsymbol % p in the small-write bookkeeping
+  std::vector<unsigned> m_DiagNums;
+  std::vector<unsigned> m_AntiDiagNums;
+
+  /// scratch space of a processing thread, allocated by Attach
+  struct Workspace {
+    /// p symbols of a stripe
+    std::vector<AlignedBuffer> symbols;
+    /// location of each symbol being decoded: either in symbols or in the caller's buffer
+    std::vector<unsigned char*> symbolData;
+    /// diagonal, anti-diagonal and row sums, p stripe units each
+    AlignedBuffer diag;
+    AlignedBuffer adiag;
+    AlignedBuffer row;
+    /// right-hand side of the triple erasure equations, p stripe units
+    AlignedBuffer rhs;
+    /// the middle symbol obtained by the closed form in the self-check mode
+    AlignedBuffer check;
+    /// old contents of up to three erased symbols updated by UpdateInformationSymbols
+    AlignedBuffer erasedData;
+    /// source pointers for XORN, p entries
+    std::vector<unsigned char const*> sources;
+    /// row, diagonal and anti-diagonal units touched by UpdateInformationSymbols
+    std::vector<unsigned char> loaded;
+    /// which units of the p+2 symbols are involved in PeelSubsymbols
+    std::vector<unsigned char> involved;
+    /// units to be solved and solved by PeelSubsymbols
+    std::vector<unsigned> pending;
+    std::vector<unsigned> needed;
+  };
+
+  /// one workspace per ThreadID
+  std::vector<Workspace> m_Workspaces;
+
+  /// read a stripe and restore its erased symbols. Symbols [FirstSymbolID, LastSymbolID)
+  /// are placed in pDest if it is not null, and the other ones in ws.symbols.
+  /// Erased symbols outside of this range may be left unrestored.
+  /// ws.symbolData points to the resulting symbols
+  ///@return true on success
+  [[nodiscard]] bool RestoreSymbols(unsigned long long StripeID,
+                                    unsigned ErasureSetID,
+                                    unsigned FirstSymbolID,
+                                    unsigned LastSymbolID,
+                                    unsigned char* pDest,
+                                    Workspace& ws);
+
+  /// restore bytes [Offset, Offset+Size) of each stripe unit of two erased symbols X<Y, walking
+  /// the diagonal (or anti-diagonal) chain that starts at the unstored diagonal.
+  /// diag must contain the diagonal sums of all other symbols, and is partially overwritten
+  void RestoreChain(unsigned X,
+                    unsigned Y,
+                    bool isAnti,
+                    unsigned char* const* symbols,     /// the p RAID4 symbols
+                    unsigned char* diag,                /// diagonal or anti-diagonal sums
+                    unsigned char const** rowSources,  /// room for p source pointers
+                    std::size_t Offset,
+                    std::size_t Size) const;
+
+  /// restore bytes [Offset, Offset+Size) of each stripe unit of the middle one of three erased
+  /// RAID4 symbols X<Y<Z. Unit k of rhs is the 4-tuple sum Y[k]+Y[k+v]+Y[k+u]+Y[k+u+v],
+  /// where u=Y-X, v=Z-Y, indices are taken modulo p and Y[p-1] is zero.
+  /// With P[k]=Y[k]+Y[k+u] it is P[k]+P[k+v], so walking the chain k, k+v, ... gives P up to
+  /// a constant c, which is fixed by P summing up to zero. Walking the chain k, k+u, ...
+  /// from Y[p-1] gives then Y. rhs and pairs are p units each, and both are overwritten
+  void RestoreMiddleSymbol(unsigned YX,
+                           unsigned ZX,
+                           unsigned char* rhs,
+                           unsigned char* pairs,
+                           unsigned char* y,
+                           unsigned char const** sources,  /// room for p source pointers
+                           std::size_t Offset,
+                           std::size_t Size) const;
+
+  /// XOR schedule recovering the middle one of three erased RAID4 symbols X<Y<Z.
+  /// Y's subsymbol i is the sum of the rows rows[start[i]..start[i+1]) of the
+  /// right-hand side built in DecodeDataSymbols. This is the Gaussian elimination fallback
+  /// for RestoreMiddleSymbol
+  struct TripleErasurePlan {
+    std::vector<unsigned> start;
+    std::vector<unsigned> rows;
+  };
+
+  /// the plans depend only on (Y-X, Z-X), so they are shared by all load balancing offsets.
+  /// They are built by IsCorrectable before any I/O is done, and only read afterwards.
+  /// They are not used by the closed form decoder
+  std::map<std::pair<unsigned, unsigned>, TripleErasurePlan> m_TriplePlans;
+
+  [[nodiscard]] TripleErasurePlan BuildTripleErasurePlan(unsigned YX, unsigned ZX) const;
+
+  /// Equations of the code are numbered as follows: rows 0..p-2, then diagonals 0..p-2,
+  /// then anti-diagonals 0..p-2. Units are numbered as symbolId*(p-1)+subsymbolId
+  ///@return the row of RAID4 symbol s involved in equation e, or p-1 if there is none
+  [[nodiscard]] unsigned EquationRow(unsigned e, unsigned s) const;
+
+  ///@return the parity symbol of a diagonal or anti-diagonal equation
+  [[nodiscard]] inline unsigned ParityDisk(unsigned e) const noexcept {
+    return (e < 2 * m_StripeUnitsPerSymbol) ? p : p + 1;
+  }
+
+  /// peeling decoder for two erased RAID4 symbols
+  struct PeelingPlan {
+    /// the equation solving each erased unit, or -1
+    std::vector<int> solver;
+    /// the position of each erased unit in the solution sequence
+    std::vector<unsigned> order;
+  };
+
+  /// the plans keyed by the erased positions as returned by GetErasedSymbols.
+  /// They are built by IsCorrectable, and only read afterwards
+  std::map<std::array<int, 3>, PeelingPlan> m_PeelingPlans;
+
+  [[nodiscard]] PeelingPlan BuildPeelingPlan(std::array<int, 3> const& erased) const;
+
+  /// recover some subsymbols of an erased symbol, reading only the units
+  /// on the chains of equations leading to them
+  ///@return true on success
+  [[nodiscard]] bool PeelSubsymbols(unsigned long long StripeID,
+                                    unsigned ErasureSetID,
+                                    unsigned SymbolID,
+                                    unsigned SubsymbolID,
+                                    unsigned Subsymbols2Decode,
+                                    unsigned char* pDest,
+                                    Workspace& ws);
 
   [[nodiscard]] unsigned int GetNumErasedRaid4Symbols(unsigned int ErasureSetID) const;
   [[nodiscard]] std::array<int, 3> GetErasedSymbols(unsigned int ErasureSetID) const;
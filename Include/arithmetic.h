@@ -15,21 +15,42 @@
 #include <immintrin.h>
 
 
-#ifdef AVX
-//use AVX code
-#define ARITHMETIC_ALIGNMENT 32
-typedef __m256 MMType;
-#define MMXOR(A,B)  _mm256_xor_ps(A,B)
-#else 
-//use SSE3 code
+///granularity of the block sizes accepted by the arithmetic functions
 #define ARITHMETIC_ALIGNMENT 16
+///alignment of the blocks returned by AlignedMalloc.
+///This is the width of the widest vector registers the kernels may use
+#define MEMORY_ALIGNMENT 64
 typedef __m128i MMType;
 #define MMXOR(A,B)  _mm_xor_si128(A,B)
-#endif
 
 #define MMSTORE(DestAddr,Src) *(MMType*)(DestAddr)=Src
 #define MMLOAD(addr) *(const MMType*)(addr) 
 
+//functions using instructions beyond SSE2 must be explicitly marked as such,
+//since the baseline code is compiled for SSE2 only
+#if defined(__GNUC__)
+#define ISA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ISA_TARGET(isa)
+#endif
+
+///instruction set extensions supported by the arithmetic kernels
+///The kernels are selected at startup according to the CPU capabilities
+///The entries are sorted by preference
+enum eArithmeticISA{isaSSE2,isaSSSE3,isaAVX2,isaAVX2GFNI,isaAVX512BW,isaAVX512GFNI,isaEnd};
+///human-readable names for each instruction set
+extern const char* pISANames[];
+///@return true if the CPU can execute the kernels for a given instruction set
+bool IsISASupported(eArithmeticISA ISA);
+///use the kernels for a given instruction set
+///@return false if it is not supported by the CPU
+bool SelectArithmeticISA(eArithmeticISA ISA);
+///use the kernels for a given instruction set specified by name (see pISANames)
+///@return false if the name is unknown or the instruction set is not supported by the CPU
+bool SelectArithmeticISA(const char* pName);
+///@return the instruction set used by the arithmetic kernels
+eArithmeticISA GetArithmeticISA();
+
 ///memory allocation as needed by the arithmetic functions
 unsigned char* AlignedMalloc(size_t Size);
 ///memory deallocation for aligned pointers
@@ -37,8 +58,7 @@ void AlignedFree(void* ptr);
 
 
 ///XOR arrays A and B, storing the result in A
-///the size of the arrays must be a multiple of 32
-///the arrays must be aligned to ARITHMETIC_ALIGNMENT boundary
+///the size of the arrays must be a multiple of ARITHMETIC_ALIGNMENT
 void XOR(unsigned char* pA,const unsigned char* pB,unsigned Size);
 ///OR arrays A, B and C, storing the result in D
 ///Everything must be aligned
@@ -48,12 +68,44 @@ void XOR (const unsigned char* pA,const unsigned char* pB,const unsigned char* p
 void XOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,unsigned Size );
 ///XOR arrays A and B, and XOR the result to  C
 void XORXOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,unsigned Size );
+///XOR n arrays, storing the result in Dest. Dest is written only once, and may coincide with any of the sources.
+///If n==0, Dest is set to zero
+void XORN(unsigned char* pDest,///the destination array
+          const unsigned char* const* ppSrc,///the arrays to be summed up
+          unsigned n,///the number of arrays
+          unsigned Size///the size of each array
+          );
+///add the source array to n destination arrays, loading it only once.
+///The destinations must not overlap the source
+void XORScatter(const unsigned char* pSrc,///the array to be added
+                unsigned char* const* ppDest,///the arrays to be updated
+                unsigned n,///the number of destination arrays
+                unsigned Size///the size of each array
+                );
+///check if the sum of n arrays is zero, without storing it anywhere
+///The arrays may have arbitrary size
+bool IsXORZero(const unsigned char* const* ppSrc,///the arrays to be summed up
+               unsigned n,///the number of arrays
+               size_t Size///the size of each array
+               );
+///check if all entries of an array are zero
+bool IsZero(const unsigned char* pA,size_t Size);
+///check if two arrays are equal
+bool Equal(const unsigned char* pA,const unsigned char* pB,size_t Size);
 
 ///this is GF(2^m) arithmetic
 ///it supports m<=8
 typedef unsigned char GFValue;
 GFValue multBy2(GFValue v,unsigned w);
 GFValue singleMult(GFValue v1,GFValue v2,unsigned w);
+///@return the inverse of a non-zero element of the field constructed by InitGF
+GFValue singleInverse(GFValue v);
+///invert a matrix over the field constructed by InitGF using Gauss-Jordan elimination
+///@return false if the matrix is singular
+bool InvertGFMatrix(const GFValue* pMatrix,///the matrix to be inverted, row-major
+                    GFValue* pInverse,///receives the inverse matrix, row-major
+                    unsigned Size///the number of rows and columns
+                   );
 ///construct GF(2^m) tables. The primitive polynomial is taken from a table
 ///@return false if m is too large
 void InitGF(unsigned m);
@@ -82,10 +134,13 @@ struct MultiplyHelper
     };
 };
 extern MultiplyHelper* pHelper;
+///8x8 bit matrices of multiplication by \alpha^x, as needed by GF2P8AFFINEQB instruction.
+///Byte 7-i of the matrix gives the contribution of each input bit to the i-th bit of the product
+extern unsigned long long* pAffine;
 extern const __m128i* pMask0F;
 
 ///elementary multiplication
-inline void  Multiply(int x,///scale factor
+ISA_TARGET("ssse3") inline void  Multiply(int x,///scale factor
                       const __m128i& A,
                       __m128i& Dest)
 {
@@ -126,6 +181,16 @@ void MultiplySum(int x,///scale factor
     unsigned Size///block size
     );
 
+///compute r linear combinations of k data blocks in a single pass over the data:
+//ppDest[j][i]=\sum_{l=0}^{k-1} ppSrc[l][i]*\alpha^{pCoefficients[j*k+l]}, 0<=j<r
+void DotProduct(const GFValue* const* ppSrc,///the input blocks
+                unsigned k,///the number of input blocks
+                const int* pCoefficients,///r x k matrix of scale factors (logarithms). Negative values stand for zero
+                GFValue* const* ppDest,///the output blocks. They must not overlap with the inputs
+                unsigned r,///the number of output blocks
+                unsigned Size///block size
+                );
+
 
 extern unsigned* GF;
 extern int* LogTable;
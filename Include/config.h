@@ -15,8 +15,6 @@
 #define OPERATION_COUNTING
 //implement disk emulator via memory-mapped files
 #define USE_MMAP
-//enable AVX processing
-//#define AVX
 
 //student version build
 #define STUDENTBUILD
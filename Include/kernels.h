@@ -0,0 +1,60 @@
+/*********************************************************
+ * kernels.h  - dispatch table for the vectorized arithmetic kernels
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include "arithmetic.h"
+
+///implementations of the arithmetic functions for a specific instruction set
+///The kernels accept arbitrary alignment of the arrays and arbitrary block sizes.
+///Argument validation and operation counting are done by the wrappers in arithmetic.cpp
+struct ArithmeticKernels
+{
+    ///pA[i]^=pB[i]
+    void (*XOR)(unsigned char* pA,const unsigned char* pB,size_t Size);
+    ///pC[i]=pA[i]^pB[i]
+    void (*XOR3)(const unsigned char* pA,const unsigned char* pB,unsigned char* pC,size_t Size);
+    ///pD[i]=pA[i]^pB[i]^pC[i]
+    void (*XOR4)(const unsigned char* pA,const unsigned char* pB,const unsigned char* pC,unsigned char* pD,size_t Size);
+    ///pC[i]^=pA[i]^pB[i]
+    void (*XORXOR)(const unsigned char* pA,const unsigned char* pB,unsigned char* pC,size_t Size);
+    ///pDest[i]=ppSrc[0][i]^...^ppSrc[n-1][i], n>0. pDest may coincide with any of ppSrc[j]
+    void (*XORN)(unsigned char* pDest,const unsigned char* const* ppSrc,size_t n,size_t Size);
+    ///ppDest[j][i]^=pSrc[i] for all j<n. The destinations must not overlap the source
+    void (*XORScatter)(const unsigned char* pSrc,unsigned char* const* ppDest,size_t n,size_t Size);
+    ///check if ppSrc[0][i]^...^ppSrc[n-1][i]==0 for all i, n>0
+    bool (*IsXORZero)(const unsigned char* const* ppSrc,size_t n,size_t Size);
+    ///GF kernels multiply by \alpha^x, where 0<=x<FieldSize_1 indexes pHelper and pAffine
+    ///pDest[i]=pSrc[i]*\alpha^x
+    void (*Multiply)(int x,const GFValue* pSrc,GFValue* pDest,size_t Size);
+    ///pDest[i]^=pSrc[i]*\alpha^x
+    void (*MultiplyAdd)(int x,const GFValue* pSrc,GFValue* pDest,size_t Size);
+    ///pSrc[i]=(pSrc[i]*\alpha^x)^pCorrection[i]
+    void (*AddMultiply)(int x,GFValue* pSrc,const GFValue* pCorrection,size_t Size);
+    ///pDest[i]=(pSrc1[i]^pSrc2[i])*\alpha^x
+    void (*MultiplySum)(int x,const GFValue* pSrc1,const GFValue* pSrc2,GFValue* pDest,size_t Size);
+    ///ppDest[j][i]=\sum_l ppSrc[l][i]*\alpha^{pCoefficients[j*k+l]}, negative coefficients stand for zero
+    void (*DotProduct)(const GFValue* const* ppSrc,size_t k,const int* pCoefficients,GFValue* const* ppDest,size_t r,size_t Size);
+};
+
+///kernels for each instruction set. Each table is implemented in RAID/kernels_<isa>.cpp,
+///which is the only translation unit compiled with the corresponding instruction set enabled
+extern const ArithmeticKernels KernelsSSE2;
+extern const ArithmeticKernels KernelsSSSE3;
+extern const ArithmeticKernels KernelsAVX2;
+extern const ArithmeticKernels KernelsAVX2GFNI;
+extern const ArithmeticKernels KernelsAVX512BW;
+extern const ArithmeticKernels KernelsAVX512GFNI;
+
+///the kernels selected for the current CPU
+extern const ArithmeticKernels* pKernels;
+
+#endif
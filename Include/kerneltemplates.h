@@ -0,0 +1,504 @@
+#pragma once
+
+// Generic bodies of the arithmetic kernels.
+// This header is included only by RAID/kernels_<isa>.cpp, each of which is compiled with a
+// different instruction set. Everything here has internal linkage, so that the linker never
+// merges e.g. an AVX-512 instantiation into the SSE2 table.
+
+#include <immintrin.h>
+#include <cstddef>
+#include "kernels.h"
+
+namespace {
+
+template <class... Vectors>
+struct VectorList {};
+
+/// the lookup tables of multiplication by zero
+MultiplyHelper const ZeroHelper = {};
+
+///@return the lookup tables of multiplication by \alpha^x, or by zero if x<0
+inline MultiplyHelper const& GetHelper(int x) {
+  return (x < 0) ? ZeroHelper : pHelper[x];
+}
+///@return the GF2P8AFFINEQB matrix of multiplication by \alpha^x, or by zero if x<0
+inline unsigned long long GetAffine(int x) {
+  return (x < 0) ? 0 : pAffine[x];
+}
+
+/// Byte-at-a-time processing. This is used for block tails and as the GF fallback for SSE2.
+struct ScalarVector {
+  using Type = unsigned char;
+  static constexpr std::size_t Width = 1;
+  static Type Load(void const* p) { return *static_cast<unsigned char const*>(p); }
+  static void Store(void* p, Type v) { *static_cast<unsigned char*>(p) = v; }
+  static Type Xor(Type a, Type b) { return a ^ b; }
+  static Type Zero() { return 0; }
+  static Type Or(Type a, Type b) { return a | b; }
+  static bool IsZero(Type a) { return a == 0; }
+
+  class Multiplier {
+    MultiplyHelper const* H;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x) : H(&GetHelper(x)) {}
+    /// the form of a multiplicand shared by the multipliers applied to it
+    using Operand = Type;
+    static Operand Split(Type a) { return a; }
+    Type operator()(Type a) const { return H->LookupLow[a & 0x0F] ^ H->LookupHigh[a >> 4]; }
+  };
+};
+
+#ifdef __SSE2__
+struct SSE2Vector {
+  using Type = __m128i;
+  static constexpr std::size_t Width = 16;
+  static Type Load(void const* p) { return _mm_loadu_si128(static_cast<__m128i const*>(p)); }
+  static void Store(void* p, Type v) { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+  static Type Xor(Type a, Type b) { return _mm_xor_si128(a, b); }
+  static Type Zero() { return _mm_setzero_si128(); }
+  static Type Or(Type a, Type b) { return _mm_or_si128(a, b); }
+  static bool IsZero(Type a) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0xFFFF;
+  }
+};
+#endif
+
+#ifdef __SSSE3__
+/// The product y*x is computed as LookupLow[y & 0xF] ^ LookupHigh[y >> 4],
+/// with both lookups done for all bytes at once by pshufb
+struct SSSE3Vector : SSE2Vector {
+  class Multiplier {
+    Type Low, High;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x)
+        : Low(Load(GetHelper(x).LookupLow)),
+          High(Load(GetHelper(x).LookupHigh)) {}
+    /// the low and high nibbles of a multiplicand, so that they are extracted only once
+    /// for all multipliers applied to it
+    struct Operand {
+      Type Low, High;
+    };
+    static Operand Split(Type a) {
+      auto const Mask = _mm_set1_epi8(0x0F);
+      return {_mm_and_si128(a, Mask), _mm_and_si128(_mm_srli_epi16(a, 4), Mask)};
+    }
+    Type operator()(Operand const& a) const {
+      return _mm_xor_si128(_mm_shuffle_epi8(Low, a.Low), _mm_shuffle_epi8(High, a.High));
+    }
+    Type operator()(Type a) const { return (*this)(Split(a)); }
+  };
+};
+#endif
+
+#ifdef __AVX2__
+struct AVX2Vector {
+  using Type = __m256i;
+  static constexpr std::size_t Width = 32;
+  static Type Load(void const* p) { return _mm256_loadu_si256(static_cast<__m256i const*>(p)); }
+  static void Store(void* p, Type v) { _mm256_storeu_si256(static_cast<__m256i*>(p), v); }
+  static Type Xor(Type a, Type b) { return _mm256_xor_si256(a, b); }
+  static Type Zero() { return _mm256_setzero_si256(); }
+  static Type Or(Type a, Type b) { return _mm256_or_si256(a, b); }
+  static bool IsZero(Type a) { return _mm256_testz_si256(a, a); }
+
+  /// vpshufb works within 128-bit lanes, so the tables are replicated into both of them
+  class Multiplier {
+    Type Low, High;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x)
+        : Low(_mm256_broadcastsi128_si256(GetHelper(x).Lookup0)),
+          High(_mm256_broadcastsi128_si256(GetHelper(x).Lookup1)) {}
+    /// the low and high nibbles of a multiplicand, so that they are extracted only once
+    /// for all multipliers applied to it
+    struct Operand {
+      Type Low, High;
+    };
+    static Operand Split(Type a) {
+      auto const Mask = _mm256_set1_epi8(0x0F);
+      return {_mm256_and_si256(a, Mask), _mm256_and_si256(_mm256_srli_epi16(a, 4), Mask)};
+    }
+    Type operator()(Operand const& a) const {
+      return _mm256_xor_si256(_mm256_shuffle_epi8(Low, a.Low), _mm256_shuffle_epi8(High, a.High));
+    }
+    Type operator()(Type a) const { return (*this)(Split(a)); }
+  };
+};
+#endif
+
+#ifdef __AVX512BW__
+struct AVX512BWVector {
+  using Type = __m512i;
+  static constexpr std::size_t Width = 64;
+  static Type Load(void const* p) { return _mm512_loadu_si512(p); }
+  static void Store(void* p, Type v) { _mm512_storeu_si512(p, v); }
+  static Type Xor(Type a, Type b) { return _mm512_xor_si512(a, b); }
+  static Type Zero() { return _mm512_setzero_si512(); }
+  static Type Or(Type a, Type b) { return _mm512_or_si512(a, b); }
+  static bool IsZero(Type a) { return _mm512_test_epi64_mask(a, a) == 0; }
+
+  /// vpshufb works within 128-bit lanes, so the tables are replicated into all of them
+  class Multiplier {
+    Type Low, High;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x)
+        : Low(_mm512_broadcast_i32x4(GetHelper(x).Lookup0)),
+          High(_mm512_broadcast_i32x4(GetHelper(x).Lookup1)) {}
+    /// the low and high nibbles of a multiplicand, so that they are extracted only once
+    /// for all multipliers applied to it
+    struct Operand {
+      Type Low, High;
+    };
+    static Operand Split(Type a) {
+      auto const Mask = _mm512_set1_epi8(0x0F);
+      return {_mm512_and_si512(a, Mask), _mm512_and_si512(_mm512_srli_epi16(a, 4), Mask)};
+    }
+    Type operator()(Operand const& a) const {
+      return _mm512_xor_si512(_mm512_shuffle_epi8(Low, a.Low), _mm512_shuffle_epi8(High, a.High));
+    }
+    Type operator()(Type a) const { return (*this)(Split(a)); }
+  };
+};
+#endif
+
+#ifdef __GFNI__
+/// With GFNI, multiplication by a constant is a single affine transformation of each byte,
+/// valid for any field polynomial. The matrix is given by pAffine[x].
+struct SSEGFNIVector : SSE2Vector {
+  class Multiplier {
+    Type A;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x) : A(_mm_set1_epi64x(GetAffine(x))) {}
+    using Operand = Type;
+    static Operand Split(Type a) { return a; }
+    Type operator()(Type a) const { return _mm_gf2p8affine_epi64_epi8(a, A, 0); }
+  };
+};
+
+#ifdef __AVX2__
+struct AVX2GFNIVector : AVX2Vector {
+  class Multiplier {
+    Type A;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x) : A(_mm256_set1_epi64x(GetAffine(x))) {}
+    using Operand = Type;
+    static Operand Split(Type a) { return a; }
+    Type operator()(Type a) const { return _mm256_gf2p8affine_epi64_epi8(a, A, 0); }
+  };
+};
+#endif
+
+#ifdef __AVX512BW__
+struct AVX512GFNIVector : AVX512BWVector {
+  class Multiplier {
+    Type A;
+
+   public:
+    Multiplier() = default;
+    explicit Multiplier(int x) : A(_mm512_set1_epi64(GetAffine(x))) {}
+    using Operand = Type;
+    static Operand Split(Type a) { return a; }
+    Type operator()(Type a) const { return _mm512_gf2p8affine_epi64_epi8(a, A, 0); }
+  };
+};
+#endif
+#endif
+
+/// Split [0, Size) into ranges processed by each of the vector types in turn.
+/// body(Vector{}, Begin, End) is called with End-Begin being a multiple of Vector::Width.
+/// The last vector type must be ScalarVector, so that everything gets processed.
+template <class... Vectors, class Body>
+inline void Sweep(VectorList<Vectors...>, std::size_t Size, Body&& body) {
+  std::size_t Done = 0;
+  auto const step = [&](auto v) {
+    using V = decltype(v);
+    auto const End = Done + (Size - Done) / V::Width * V::Width;
+    body(v, Done, End);
+    Done = End;
+  };
+  (step(Vectors{}), ...);
+}
+
+/// The number of DotProduct outputs accumulated in registers at once
+constexpr std::size_t DotProductOutputs = 4;
+/// The number of DotProduct sources, whose multipliers are prepared at once
+constexpr std::size_t DotProductSources = 16;
+/// The amount of input data per DotProduct tile. It should fit into L1 cache
+constexpr std::size_t DotProductTileSize = 16 * 1024;
+
+/// Compute G outputs of DotProduct over [Begin, End).
+/// The sources are processed in chunks of DotProductSources. The multipliers of a chunk are
+/// constructed before the pass over the tile, and the partial sums are kept in the outputs.
+/// Zero and unit coefficients get multipliers too, so that the inner loop has no branches
+template <class V, std::size_t G>
+void DotProductGroup(GFValue const* const* ppSrc,
+                     std::size_t k,
+                     int const* pCoefficients,
+                     GFValue* const* ppDest,
+                     std::size_t Begin,
+                     std::size_t End) {
+  typename V::Multiplier Mult[DotProductSources][G];
+  std::size_t First = 0;
+  do {
+    auto const n = (k - First > DotProductSources) ? DotProductSources : k - First;
+    for (std::size_t l = 0; l < n; l++) {
+      for (std::size_t g = 0; g < G; g++) {
+        Mult[l][g] = typename V::Multiplier(pCoefficients[g * k + First + l]);
+      }
+    }
+    for (auto i = Begin; i < End; i += V::Width) {
+      typename V::Type Acc[G];
+      for (std::size_t g = 0; g < G; g++) {
+        Acc[g] = First ? V::Load(ppDest[g] + i) : V::Zero();
+      }
+      for (std::size_t l = 0; l < n; l++) {
+        auto const a = V::Load(ppSrc[First + l] + i);
+        auto const Operand = V::Multiplier::Split(a);
+        for (std::size_t g = 0; g < G; g++) {
+          Acc[g] = V::Xor(Acc[g], Mult[l][g](Operand));
+        }
+      }
+      for (std::size_t g = 0; g < G; g++) {
+        V::Store(ppDest[g] + i, Acc[g]);
+      }
+    }
+    First += n;
+  } while (First < k);
+}
+
+template <class XORVectors, class GFVectors>
+struct Kernels {
+  static void XOR(unsigned char* pA, unsigned char const* pB, std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pA + i, V::Xor(V::Load(pA + i), V::Load(pB + i)));
+      }
+    });
+  }
+
+  static void XOR3(unsigned char const* pA,
+                   unsigned char const* pB,
+                   unsigned char* pC,
+                   std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pC + i, V::Xor(V::Load(pA + i), V::Load(pB + i)));
+      }
+    });
+  }
+
+  static void XOR4(unsigned char const* pA,
+                   unsigned char const* pB,
+                   unsigned char const* pC,
+                   unsigned char* pD,
+                   std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pD + i, V::Xor(V::Xor(V::Load(pA + i), V::Load(pB + i)), V::Load(pC + i)));
+      }
+    });
+  }
+
+  static void XORXOR(unsigned char const* pA,
+                     unsigned char const* pB,
+                     unsigned char* pC,
+                     std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pC + i, V::Xor(V::Load(pC + i), V::Xor(V::Load(pA + i), V::Load(pB + i))));
+      }
+    });
+  }
+
+  /// Each block of XORNBlock vectors is accumulated in registers over all sources and stored
+  /// once, so the destination is written only once regardless of the number of sources.
+  static void XORN(unsigned char* pDest,
+                   unsigned char const* const* ppSrc,
+                   std::size_t n,
+                   std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      constexpr std::size_t XORNBlock = 4;
+      auto i = Begin;
+      for (; i + XORNBlock * V::Width <= End; i += XORNBlock * V::Width) {
+        typename V::Type Acc[XORNBlock];
+        for (std::size_t k = 0; k < XORNBlock; k++) {
+          Acc[k] = V::Load(ppSrc[0] + i + k * V::Width);
+        }
+        for (std::size_t j = 1; j < n; j++) {
+          for (std::size_t k = 0; k < XORNBlock; k++) {
+            Acc[k] = V::Xor(Acc[k], V::Load(ppSrc[j] + i + k * V::Width));
+          }
+        }
+        for (std::size_t k = 0; k < XORNBlock; k++) {
+          V::Store(pDest + i + k * V::Width, Acc[k]);
+        }
+      }
+      for (; i < End; i += V::Width) {
+        auto Acc = V::Load(ppSrc[0] + i);
+        for (std::size_t j = 1; j < n; j++) {
+          Acc = V::Xor(Acc, V::Load(ppSrc[j] + i));
+        }
+        V::Store(pDest + i, Acc);
+      }
+    });
+  }
+
+  /// Each source vector is loaded once and added to all destinations
+  static void XORScatter(unsigned char const* pSrc,
+                         unsigned char* const* ppDest,
+                         std::size_t n,
+                         std::size_t Size) {
+    Sweep(XORVectors{}, Size, [=](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      for (auto i = Begin; i < End; i += V::Width) {
+        auto const a = V::Load(pSrc + i);
+        for (std::size_t j = 0; j < n; j++) {
+          V::Store(ppDest[j] + i, V::Xor(V::Load(ppDest[j] + i), a));
+        }
+      }
+    });
+  }
+
+  /// The data is processed in tiles small enough for the inputs to stay in L1 cache while
+  /// groups of DotProductOutputs outputs are computed from them
+  static void DotProduct(GFValue const* const* ppSrc,
+                         std::size_t k,
+                         int const* pCoefficients,
+                         GFValue* const* ppDest,
+                         std::size_t r,
+                         std::size_t Size) {
+    Sweep(GFVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      auto Tile = DotProductTileSize / (k ? k : 1) / V::Width * V::Width;
+      if (Tile < V::Width) {
+        Tile = V::Width;
+      }
+      for (auto t = Begin; t < End; t += Tile) {
+        auto const TileEnd = (End - t > Tile) ? t + Tile : End;
+        for (std::size_t j = 0; j < r; j += DotProductOutputs) {
+          auto const pC = pCoefficients + j * k;
+          switch (r - j) {
+            case 1:
+              DotProductGroup<V, 1>(ppSrc, k, pC, ppDest + j, t, TileEnd);
+              break;
+            case 2:
+              DotProductGroup<V, 2>(ppSrc, k, pC, ppDest + j, t, TileEnd);
+              break;
+            case 3:
+              DotProductGroup<V, 3>(ppSrc, k, pC, ppDest + j, t, TileEnd);
+              break;
+            default:
+              DotProductGroup<V, DotProductOutputs>(ppSrc, k, pC, ppDest + j, t, TileEnd);
+              break;
+          }
+        }
+      }
+    });
+  }
+
+  /// The sums are ORed together, and tested for zero once per block of XORNBlock vectors,
+  /// so that the test terminates soon after the first mismatch
+  static bool IsXORZero(unsigned char const* const* ppSrc, std::size_t n, std::size_t Size) {
+    bool Zero = true;
+    Sweep(XORVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      constexpr std::size_t XORNBlock = 4;
+      for (auto i = Begin; Zero && i < End; i += XORNBlock * V::Width) {
+        auto const BlockEnd = (End - i > XORNBlock * V::Width) ? i + XORNBlock * V::Width : End;
+        auto Acc = V::Zero();
+        for (auto b = i; b < BlockEnd; b += V::Width) {
+          auto Sum = V::Load(ppSrc[0] + b);
+          for (std::size_t j = 1; j < n; j++) {
+            Sum = V::Xor(Sum, V::Load(ppSrc[j] + b));
+          }
+          Acc = V::Or(Acc, Sum);
+        }
+        Zero = V::IsZero(Acc);
+      }
+    });
+    return Zero;
+  }
+
+  static void Multiply(int x, GFValue const* pSrc, GFValue* pDest, std::size_t Size) {
+    Sweep(GFVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      typename V::Multiplier const M(x);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pDest + i, M(V::Load(pSrc + i)));
+      }
+    });
+  }
+
+  static void MultiplyAdd(int x, GFValue const* pSrc, GFValue* pDest, std::size_t Size) {
+    Sweep(GFVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      typename V::Multiplier const M(x);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pDest + i, V::Xor(V::Load(pDest + i), M(V::Load(pSrc + i))));
+      }
+    });
+  }
+
+  static void AddMultiply(int x, GFValue* pSrc, GFValue const* pCorrection, std::size_t Size) {
+    Sweep(GFVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      typename V::Multiplier const M(x);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pSrc + i, V::Xor(V::Load(pCorrection + i), M(V::Load(pSrc + i))));
+      }
+    });
+  }
+
+  static void MultiplySum(int x,
+                          GFValue const* pSrc1,
+                          GFValue const* pSrc2,
+                          GFValue* pDest,
+                          std::size_t Size) {
+    Sweep(GFVectors{}, Size, [&](auto v, std::size_t Begin, std::size_t End) {
+      using V = decltype(v);
+      typename V::Multiplier const M(x);
+      for (auto i = Begin; i < End; i += V::Width) {
+        V::Store(pDest + i, M(V::Xor(V::Load(pSrc1 + i), V::Load(pSrc2 + i))));
+      }
+    });
+  }
+};
+
+/// Fill the dispatch table.
+/// XORVectors and GFVectors list the vector types from the widest to ScalarVector.
+template <class XORVectors, class GFVectors>
+constexpr ArithmeticKernels MakeKernels() {
+  using K = Kernels<XORVectors, GFVectors>;
+  return ArithmeticKernels{
+      .XOR = K::XOR,
+      .XOR3 = K::XOR3,
+      .XOR4 = K::XOR4,
+      .XORXOR = K::XORXOR,
+      .XORN = K::XORN,
+      .XORScatter = K::XORScatter,
+      .IsXORZero = K::IsXORZero,
+      .Multiply = K::Multiply,
+      .MultiplyAdd = K::MultiplyAdd,
+      .AddMultiply = K::AddMultiply,
+      .MultiplySum = K::MultiplySum,
+      .DotProduct = K::DotProduct,
+  };
+}
+
+}  // namespace
@@ -70,6 +70,28 @@ void InitCRC32();
 ///process data block and update CRC counter
 void UpdateCRC32(unsigned & CRC, size_t size, const unsigned char *buf);
 
+///CRC32C implementations. The fastest one supported by the CPU is selected at startup
+enum eCRC32CImplementation
+{
+    crcSlicing8,///portable slicing-by-8 table lookup
+    crcSSE42,///3-way interleaved SSE4.2 crc32 instruction
+    crcEnd
+};
+extern const char* pCRC32CNames[crcEnd];
+///check if the CPU supports a given CRC32C implementation
+bool IsCRC32CSupported(eCRC32CImplementation Implementation);
+///select the CRC32C implementation
+///@return false if it is not supported by the CPU
+bool SelectCRC32C(eCRC32CImplementation Implementation);
+///select the CRC32C implementation by name (see pCRC32CNames)
+///@return false if it is unknown or not supported by the CPU
+bool SelectCRC32C(const char* pName);
+///get the current CRC32C implementation
+eCRC32CImplementation GetCRC32C();
+///process data block and update CRC32C (Castagnoli) value. The initial value is 0,
+///and the result is the standard CRC32C, so the data may be processed in several blocks
+void UpdateCRC32C(unsigned& CRC,size_t Size,const unsigned char* pBuf);
+
 ///get current time
 void GetTimes(double& UserTime,///user-mode process time
              double& KernelTime,///kernel-mode process time
@@ -77,26 +99,47 @@ void GetTimes(double& UserTime,///user-mode process time
              );
 
 #ifdef OPERATION_COUNTING
+#include <atomic>
 //different operation types
 enum eOperations{opXOR,opGFMul,opGFMulAdd,opRead,opWrite,opEnd};
-//counter for each operation
-extern volatile unsigned long long OPCount[];
 //human-readable names for each operation
 extern const char* pOpNames[];
-//reset operation counters
+//reset operation counters. This should be called while no operations are being performed
 bool ResetOpCount();
+//get the total number of operations of a given type performed by all threads
+unsigned long long GetOpCount(eOperations Type);
+//enable or disable operation counting at runtime
+void EnableOpCounting(bool Enable);
+//check if operation counting is enabled
+bool IsOpCountingEnabled();
+
+///operation counters of a single thread. Only the owner thread updates them, so no atomic
+///read-modify-write is needed. Shards are aligned to cache lines to avoid false sharing
+struct alignas(64) OpCountShard
+{
+    std::atomic<unsigned long long> Count[opEnd];
+    ///next shard in the list of all shards
+    OpCountShard* pNext;
+};
+//the shard of the current thread, allocated on its first counted operation
+inline thread_local OpCountShard* pOpCountShard=0;
+//allocate a shard for the current thread
+OpCountShard* RegisterOpCountShard();
+extern bool OpCountingEnabled;
+
+//update a counter of the current thread
+inline void CountOperation(eOperations Type,unsigned long long x)
+{
+    OpCountShard* pShard=pOpCountShard;
+    if (!pShard)
+        pShard=RegisterOpCountShard();
+    std::atomic<unsigned long long>& C=pShard->Count[Type];
+    C.store(C.load(std::memory_order_relaxed)+x,std::memory_order_relaxed);
+};
 
-
-
-//atomic updating of a counter
-#ifdef WIN32
-#include <Windows.h>
-#define LOCKEDADD(Type,x) InterlockedAdd64((LONG64*)&OPCount[Type],x)
-#else
-#define LOCKEDADD(Type,x)  __sync_fetch_and_add(&OPCount[Type],x)
-#endif
+#define COUNTOP(Type,x) do{ if (OpCountingEnabled) CountOperation(Type,x); }while(0)
 #else
-#define LOCKEDADD(Type,x)
+#define COUNTOP(Type,x)
 #endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*********************************************************
+ * workerpool.h  - header file for a pool of worker threads
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+#include <thread>
+#include <vector>
+#include "sync.h"
+
+///a fixed set of threads shared by all the processing threads. It is used to split
+///a single CPU-heavy operation (e.g. decoding a large stripe unit) into independent tasks
+class CWorkerPool {
+    ///a batch of tasks submitted by a single Run() call
+    struct Job {
+        ///the task to be executed for each index
+        const std::function<void(unsigned)>* pTask;
+        ///the total number of tasks
+        unsigned NumOfTasks;
+        ///the index of the next task to be started
+        unsigned NextTask;
+        ///the number of tasks which have not been completed yet
+        unsigned Pending;
+        ///the next job in the queue
+        Job* pNext;
+    };
+    ///worker threads
+    std::vector<std::thread> m_Workers;
+    ///the queue of jobs with unstarted tasks
+    Job* m_pQueueHead;
+    ///the last element of the job queue
+    Job* m_pQueueTail;
+    ///set to true to make the workers exit
+    bool m_Shutdown;
+    ///protects the job queue and the job state
+    tCriticalSection m_Mutex;
+    ///signalled when a new job is queued
+    tCondVariable m_WorkAvailable;
+    ///signalled when some job is completed
+    tCondVariable m_JobDone;
+
+    ///take the next task of a job, and remove the job from the queue once all its tasks are started.
+    ///The mutex must be held
+    ///@return the task index
+    unsigned TakeTask(Job* pJob);
+    ///execute a task taken from the job and update its state. The mutex must be held, and is temporarily released
+    void Execute(Job* pJob, unsigned TaskID);
+    ///the worker thread body
+    void WorkerLoop();
+public:
+    CWorkerPool(unsigned NumOfWorkers ///the number of threads to spawn
+            );
+    ~CWorkerPool();
+    ///@return the number of worker threads
+    unsigned GetNumOfWorkers()const
+    {
+        return (unsigned)m_Workers.size();
+    };
+    ///execute Task(i) for i=0..NumOfTasks-1 and wait for all of them to complete.
+    ///The calling thread executes the tasks too, so this may be safely called by several threads at once
+    void Run(unsigned NumOfTasks, ///the number of tasks
+             const std::function<void(unsigned)>& Task ///the task body
+            );
+};
+
+///create the shared worker pool. This should be called before any processing is started
+void InitWorkerPool(unsigned NumOfWorkers ///the number of worker threads. 0 disables the pool
+        );
+///@return the shared worker pool, or 0 if it is disabled
+CWorkerPool* GetWorkerPool();
+
+#endif
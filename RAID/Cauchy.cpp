@@ -0,0 +1,540 @@
+/*********************************************************
+ * Cauchy.cpp  - implementation for a Cauchy Reed-Solomon based RAID
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include <algorithm>
+#include <string.h>
+#include "misc.h"
+#include "Cauchy.h"
+
+using namespace std;
+//the code is defined over GF(2^8), so each stripe unit consists of 8 packets
+#define Extension 8
+//common subexpression elimination is performed only for schedules with at most
+//this number of input packets, since the pair counts take quadratic memory
+#define CSE_MAX_INPUTS 512
+
+/**Initialize the Cauchy matrix C_{ij}=1/(x_i+y_j), x_i=i, y_j=r+j,
+and scale it to reduce the number of XORs*/
+CCauchyProcessor::CCauchyProcessor(CauchyParams* pParams):
+                CRAIDProcessor(pParams->CodeDimension+pParams->Redundancy,
+                    1,pParams,sizeof(CauchyParams)),m_Redundancy(pParams->Redundancy),
+                    m_ppDecodingPlans(0),m_pSymbols(0),m_pTemps(0),m_ppXORSources(0)
+{
+    if (!m_Redundancy)
+        throw Exception("Invalid redundancy %d for Cauchy code",m_Redundancy);
+    if (m_Length>(1u<<Extension))
+        throw Exception("Cauchy code length exceeds %d",1u<<Extension);
+    if (m_StripeUnitSize%(Extension*ARITHMETIC_ALIGNMENT))
+        throw Exception("Stripe unit size must be a multiple of %d",Extension*ARITHMETIC_ALIGNMENT);
+    m_PacketSize=m_StripeUnitSize/Extension;
+    InitCS(m_PlanLock);
+
+    InitGF(Extension);
+
+    m_pCauchyMatrix=new GFValue[m_Redundancy*m_Dimension];
+    for(unsigned i=0;i<m_Redundancy;i++)
+        for(unsigned j=0;j<m_Dimension;j++)
+            m_pCauchyMatrix[i*m_Dimension+j]=singleInverse(i^(m_Redundancy+j));
+    //make the first row all-one, so that the first check symbol is just the sum of the data
+    for(unsigned j=0;j<m_Dimension;j++)
+    {
+        GFValue D=singleInverse(m_pCauchyMatrix[j]);
+        for(unsigned i=0;i<m_Redundancy;i++)
+            m_pCauchyMatrix[i*m_Dimension+j]=singleMult(m_pCauchyMatrix[i*m_Dimension+j],D,Extension);
+    };
+    //divide each of the other rows by the element, which minimizes the number of ones
+    unsigned char BitMatrix[Extension*Extension];
+    for(unsigned i=1;i<m_Redundancy;i++)
+    {
+        GFValue* pRow=m_pCauchyMatrix+i*m_Dimension;
+        unsigned BestOnes=~0u;
+        GFValue BestD=1;
+        for(unsigned d=0;d<m_Dimension;d++)
+        {
+            GFValue D=singleInverse(pRow[d]);
+            unsigned Ones=0;
+            for(unsigned j=0;j<m_Dimension;j++)
+                Ones+=GetBitMatrix(singleMult(pRow[j],D,Extension),BitMatrix);
+            if (Ones<BestOnes)
+            {
+                BestOnes=Ones;
+                BestD=D;
+            };
+        };
+        for(unsigned j=0;j<m_Dimension;j++)
+            pRow[j]=singleMult(pRow[j],BestD,Extension);
+    };
+
+    //expand the matrix into the binary one
+    unsigned Columns=Extension*m_Dimension;
+    m_pBitMatrix=new unsigned char[Extension*m_Redundancy*Columns];
+    for(unsigned i=0;i<m_Redundancy;i++)
+        for(unsigned j=0;j<m_Dimension;j++)
+        {
+            GetBitMatrix(m_pCauchyMatrix[i*m_Dimension+j],BitMatrix);
+            for(unsigned r=0;r<Extension;r++)
+                memcpy(m_pBitMatrix+(i*Extension+r)*Columns+j*Extension,BitMatrix+r*Extension,Extension);
+        };
+
+    vector<vector<unsigned> > Rows(Extension*m_Redundancy);
+    for(unsigned i=0;i<Extension*m_Redundancy;i++)
+        for(unsigned c=0;c<Columns;c++)
+            if (m_pBitMatrix[i*Columns+c])
+                Rows[i].push_back(c);
+    BuildSchedule(Rows,Columns,Columns,m_EncodingSchedule);
+};
+
+CCauchyProcessor::~CCauchyProcessor()
+{
+    delete[]m_pCauchyMatrix;
+    delete[]m_pBitMatrix;
+    delete[]m_ppDecodingPlans;
+    delete[]m_ppXORSources;
+    AlignedFree(m_pSymbols);
+    AlignedFree(m_pTemps);
+    DestroyCS(m_PlanLock);
+};
+
+/**
+Allocate memory for fetched symbols and temporary packets
+return true on success
+*/
+bool CCauchyProcessor::Attach(CDiskArray* pArray,///the disk array
+                        unsigned ConcurrentThreads ///the number of concurrent processing threads that will make calls to the processor
+                       )
+{
+    m_pSymbols=AlignedMalloc(m_Length*m_StripeUnitSize*ConcurrentThreads);
+    m_pTemps=AlignedMalloc(m_Dimension*m_StripeUnitSize*ConcurrentThreads);
+    m_ppXORSources=new const unsigned char*[16*m_Length*ConcurrentThreads];
+    m_ppDecodingPlans=new DecodingPlan*[m_Length*m_InterleavingOrder];
+    memset(m_ppDecodingPlans,0,m_Length*m_InterleavingOrder*sizeof(DecodingPlan*));
+    return CRAIDProcessor::Attach(pArray,ConcurrentThreads);
+};
+
+/**Row r, column c of the matrix is bit r of x\alpha^c
+*/
+unsigned CCauchyProcessor::GetBitMatrix(GFValue x,///the element
+                                        unsigned char* pMatrix ///8x8 matrix, row-major
+                                       )
+{
+    unsigned Ones=0;
+    for(unsigned c=0;c<Extension;c++)
+    {
+        GFValue Y=singleMult(x,1<<c,Extension);
+        for(unsigned r=0;r<Extension;r++)
+        {
+            pMatrix[r*Extension+c]=(Y>>r)&1;
+            Ones+=(Y>>r)&1;
+        };
+    };
+    return Ones;
+};
+
+/**Repeatedly find the pair of packets, which occurs in the largest number of rows, compute its sum
+into a temporary packet, and substitute it into these rows. Then each row becomes a single XORN call.
+The pairs are kept in a bucket queue by their counts, so each step costs only the updates of the affected rows
+*/
+void CCauchyProcessor::BuildSchedule(vector<vector<unsigned> >& Rows,///sources of each output packet. They are destroyed
+                                     unsigned NumOfInputs,///the number of input packets
+                                     unsigned MaxTemps,///the maximal number of temporary packets
+                                     XORSchedule& Schedule///receives the schedule
+                                    )
+{
+    Schedule.NumOfInputs=NumOfInputs;
+    Schedule.NumOfTemps=0;
+    Schedule.Dest.clear();
+    Schedule.Start.assign(1,0);
+    Schedule.Sources.clear();
+    if (NumOfInputs>CSE_MAX_INPUTS)
+        MaxTemps=0;
+    if (MaxTemps)
+    {
+        //Counts[a*N+b], a<b, is the number of rows containing both a and b.
+        //The rows are kept sorted, since each new temporary packet exceeds all the other ones
+        unsigned N=NumOfInputs+MaxTemps;
+        vector<unsigned> Counts(N*N,0);
+        for(unsigned i=0;i<Rows.size();i++)
+        {
+            const vector<unsigned>& R=Rows[i];
+            for(unsigned a=0;a<R.size();a++)
+                for(unsigned b=a+1;b<R.size();b++)
+                    Counts[R[a]*N+R[b]]++;
+        };
+        //bucket queue of the pairs a*N+b occurring in at least 2 rows. A count never exceeds the number of rows.
+        //A pair is added to a bucket each time its count changes, and the entries not matching
+        //the current count are skipped
+        vector<vector<unsigned> > Buckets(Rows.size()+1);
+        for(unsigned a=0;a<NumOfInputs;a++)
+            for(unsigned b=a+1;b<NumOfInputs;b++)
+                if (Counts[a*N+b]>=2)
+                    Buckets[Counts[a*N+b]].push_back(a*N+b);
+        unsigned Top=(unsigned)Rows.size();
+        while (Schedule.NumOfTemps<MaxTemps)
+        {
+            while (Top>=2&&(Buckets[Top].empty()||Counts[Buckets[Top].back()]!=Top))
+            {
+                if (Buckets[Top].empty())
+                    Top--;
+                else
+                    Buckets[Top].pop_back();
+            };
+            if (Top<2)
+                break;
+            unsigned Pair=Buckets[Top].back();
+            unsigned BestA=Pair/N;
+            unsigned BestB=Pair%N;
+            unsigned T=NumOfInputs+Schedule.NumOfTemps;
+            Schedule.NumOfTemps++;
+            Schedule.Dest.push_back(T);
+            Schedule.Sources.push_back(BestA);
+            Schedule.Sources.push_back(BestB);
+            Schedule.Start.push_back((unsigned)Schedule.Sources.size());
+            for(unsigned i=0;i<Rows.size();i++)
+            {
+                vector<unsigned>& R=Rows[i];
+                if (!binary_search(R.begin(),R.end(),BestA)||!binary_search(R.begin(),R.end(),BestB))
+                    continue;
+                R.erase(find(R.begin(),R.end(),BestA));
+                R.erase(find(R.begin(),R.end(),BestB));
+                Counts[Pair]--;
+                for(unsigned j=0;j<R.size();j++)
+                {
+                    unsigned X=R[j];
+                    unsigned PairA=min(X,BestA)*N+max(X,BestA);
+                    unsigned PairB=min(X,BestB)*N+max(X,BestB);
+                    if (--Counts[PairA]>=2)
+                        Buckets[Counts[PairA]].push_back(PairA);
+                    if (--Counts[PairB]>=2)
+                        Buckets[Counts[PairB]].push_back(PairB);
+                    if (++Counts[X*N+T]>=2)
+                        Buckets[Counts[X*N+T]].push_back(X*N+T);
+                };
+                R.push_back(T);
+            };
+        };
+    };
+    unsigned FirstOutput=NumOfInputs+Schedule.NumOfTemps;
+    for(unsigned i=0;i<Rows.size();i++)
+    {
+        Schedule.Dest.push_back(FirstOutput+i);
+        Schedule.Sources.insert(Schedule.Sources.end(),Rows[i].begin(),Rows[i].end());
+        Schedule.Start.push_back((unsigned)Schedule.Sources.size());
+    };
+};
+
+/**Double-checked locking: the schedule is built once, and is only read afterwards
+*/
+const XORSchedule& CCauchyProcessor::GetDecodingSchedule(DecodingPlan& Plan///the plan
+                                                        )
+{
+    if (!Plan.Ready.load(memory_order_acquire))
+    {
+        LockCS(m_PlanLock);
+        if (!Plan.Ready.load(memory_order_relaxed))
+        {
+            BuildSchedule(Plan.Rows,Extension*m_Dimension,Extension*m_Dimension,Plan.Schedule);
+            vector<vector<unsigned> >().swap(Plan.Rows);
+            Plan.Ready.store(true,memory_order_release);
+        };
+        UnlockCS(m_PlanLock);
+    };
+    return Plan.Schedule;
+};
+
+/**The packets are resolved into the input, temporary or output stripe units
+*/
+void CCauchyProcessor::RunSchedule(const XORSchedule& Schedule,///the schedule
+                                   const unsigned char* const* ppInputs,///input stripe units, 8 packets each
+                                   unsigned char* const* ppOutputs,///output stripe units, 8 packets each
+                                   size_t ThreadID ///the ID of the calling thread
+                                  )
+{
+    unsigned char* pTemps=m_pTemps+ThreadID*m_Dimension*m_StripeUnitSize;
+    const unsigned char** ppSources=m_ppXORSources+ThreadID*16*m_Length;
+    unsigned FirstOutput=Schedule.NumOfInputs+Schedule.NumOfTemps;
+    for(unsigned s=0;s<Schedule.Dest.size();s++)
+    {
+        unsigned n=0;
+        for(unsigned i=Schedule.Start[s];i<Schedule.Start[s+1];i++)
+        {
+            unsigned P=Schedule.Sources[i];
+            if (P<Schedule.NumOfInputs)
+                ppSources[n++]=ppInputs[P/Extension]+(P%Extension)*m_PacketSize;
+            else
+                ppSources[n++]=pTemps+(P-Schedule.NumOfInputs)*m_PacketSize;
+        };
+        unsigned D=Schedule.Dest[s];
+        unsigned char* pDest=(D<FirstOutput)?pTemps+(D-Schedule.NumOfInputs)*m_PacketSize
+                                            :ppOutputs[(D-FirstOutput)/Extension]+((D-FirstOutput)%Extension)*m_PacketSize;
+        XORN(pDest,ppSources,n,m_PacketSize);
+    };
+};
+
+///reset the erasure correction engine
+/// this will be called if the set of failed disks changes
+void CCauchyProcessor::ResetErasures()
+{
+    CRAIDProcessor::ResetErasures();
+    memset(m_ppDecodingPlans,0,m_Length*m_InterleavingOrder*sizeof(DecodingPlan*));
+};
+
+/**Select k surviving symbols, express the erased information symbols via them,
+and expand the coefficients for this erasure pattern into binary rows, unless it is already available
+@return true if the specified combination of erasures is correctable
+*/
+bool CCauchyProcessor::IsCorrectable(unsigned ErasureSetID///identifies the erasure combination. This will not exceed m_Length-1
+                              )
+{
+    unsigned NumOfErasures=GetNumOfErasures(ErasureSetID);
+    if (NumOfErasures>m_Redundancy) return false;
+    bool DataErased=false;
+    for(unsigned i=0;i<m_Dimension;i++)
+        DataErased|=IsErased(ErasureSetID,i);
+    if (!DataErased)
+        //only check symbols are erased
+        return true;
+    vector<unsigned> Pattern(NumOfErasures);
+    for(unsigned i=0;i<NumOfErasures;i++)
+        Pattern[i]=GetErasedPosition(ErasureSetID,i);
+    sort(Pattern.begin(),Pattern.end());
+    map<vector<unsigned>,DecodingPlan>::iterator it=m_DecodingPlans.find(Pattern);
+    if (it!=m_DecodingPlans.end())
+    {
+        m_ppDecodingPlans[ErasureSetID]=&it->second;
+        return true;
+    };
+    DecodingPlan& Plan=m_DecodingPlans[Pattern];
+    //prefer the information symbols, since they may be requested by the caller anyway
+    for(unsigned i=0;i<m_Length&&Plan.Sources.size()<m_Dimension;i++)
+        if (!IsErased(ErasureSetID,i))
+            Plan.Sources.push_back(i);
+    for(unsigned i=0;i<m_Dimension;i++)
+        if (IsErased(ErasureSetID,i))
+            Plan.Targets.push_back(i);
+    //invert the matrix expressing the sources via the information symbols
+    unsigned k=m_Dimension;
+    vector<GFValue> A(k*k,0);
+    vector<GFValue> Inv(k*k,0);
+    for(unsigned s=0;s<k;s++)
+    {
+        unsigned S=Plan.Sources[s];
+        if (S<k)
+            A[s*k+S]=1;
+        else
+            memcpy(&A[s*k],m_pCauchyMatrix+(S-k)*k,k);
+    };
+    if (!InvertGFMatrix(&A[0],&Inv[0],k))
+    {
+        m_DecodingPlans.erase(Pattern);
+        return false;
+    };
+    //expand the rows corresponding to the targets into binary ones
+    //the schedule is built by GetDecodingSchedule
+    Plan.Rows.resize(Extension*Plan.Targets.size());
+    unsigned char BitMatrix[Extension*Extension];
+    for(unsigned t=0;t<Plan.Targets.size();t++)
+        for(unsigned s=0;s<k;s++)
+        {
+            GetBitMatrix(Inv[Plan.Targets[t]*k+s],BitMatrix);
+            for(unsigned r=0;r<Extension;r++)
+                for(unsigned c=0;c<Extension;c++)
+                    if (BitMatrix[r*Extension+c])
+                        Plan.Rows[t*Extension+r].push_back(s*Extension+c);
+        };
+    m_ppDecodingPlans[ErasureSetID]=&Plan;
+    return true;
+};
+
+/**
+Fetch the non-erased symbols as is. If some of the requested symbols are erased,
+fetch the k recovery sources selected by IsCorrectable, and run the XOR schedule
+recovering all erased information symbols
+*/
+bool CCauchyProcessor::DecodeDataSymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the first symbol to be processed
+                                  unsigned Symbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 )
+{
+    bool NeedsDecoding=false;
+    for(unsigned i=0;i<Symbols2Decode;i++)
+    {
+        if (IsErased(ErasureSetID,SymbolID+i))
+            NeedsDecoding=true;
+        else
+        {
+            //fetch it
+            if (!ReadStripeUnit(StripeID,ErasureSetID,SymbolID+i,0,1,pDest+i*m_StripeUnitSize))
+                return false;
+        };
+    };
+    if (NeedsDecoding)
+    {
+        DecodingPlan* pPlan=m_ppDecodingPlans[ErasureSetID];
+        unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+        const unsigned char* ppInputs[1u<<Extension];
+        for(unsigned j=0;j<m_Dimension;j++)
+        {
+            unsigned S=pPlan->Sources[j];
+            if (S>=SymbolID&&S<SymbolID+Symbols2Decode)
+                //it has been already fetched
+                ppInputs[j]=pDest+(S-SymbolID)*m_StripeUnitSize;
+            else
+            {
+                ppInputs[j]=pFetchBuffer+S*m_StripeUnitSize;
+                if (!ReadStripeUnit(StripeID,ErasureSetID,S,0,1,pFetchBuffer+S*m_StripeUnitSize))
+                    return false;
+            };
+        };
+        //the schedule recovers all erased information symbols. The ones not requested are placed
+        //into the fetch buffer, since erased symbols are never fetched
+        unsigned char* ppOutputs[1u<<Extension];
+        for(unsigned t=0;t<pPlan->Targets.size();t++)
+        {
+            unsigned T=pPlan->Targets[t];
+            ppOutputs[t]=(T>=SymbolID&&T<SymbolID+Symbols2Decode)?pDest+(T-SymbolID)*m_StripeUnitSize
+                                                                 :pFetchBuffer+T*m_StripeUnitSize;
+        };
+        RunSchedule(GetDecodingSchedule(*pPlan),ppInputs,ppOutputs,ThreadID);
+    };
+    return true;
+};
+
+/**A request touching an erased symbol costs the k sources of its decoding plan, since the XOR
+schedule recovers all erased information symbols at once
+*/
+unsigned CCauchyProcessor::GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                       unsigned StripeUnitID,///the first stripe unit to be read
+                                       unsigned NumOfUnits,///the number of units to be read
+                                       size_t ThreadID ///the ID of the calling thread
+                                      )
+{
+    const DecodingPlan* pPlan=m_ppDecodingPlans[ErasureSetID];
+    if (!pPlan)
+        //no information symbols are erased
+        return NumOfUnits;
+    return GetRecoveryReadCost(ErasureSetID,StripeUnitID,NumOfUnits,&pPlan->Sources[0],m_Dimension);
+};
+
+/**encode and write the whole stripe.
+The check symbols are computed by the encoding XOR schedule
+@return true on success
+*/
+bool CCauchyProcessor::EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
+                              unsigned ErasureSetID,///identifies the load balancing offset
+                              const unsigned char* pData,///the data to be envoced
+                              size_t ThreadID ///the ID of the calling thread
+                 )
+{
+    bool Result=true;
+    const unsigned char* ppInputs[1u<<Extension];
+    for(unsigned i=0;i<m_Dimension;i++)
+    {
+        ppInputs[i]=pData+i*m_StripeUnitSize;
+        //send the data to disk
+        if (!IsErased(ErasureSetID,i))
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,i,0,1,pData+i*m_StripeUnitSize);
+    };
+    //use the fetch buffer as a temporary storage
+    unsigned char* pChecks=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    unsigned char* ppOutputs[1u<<Extension];
+    for(unsigned i=0;i<m_Redundancy;i++)
+        ppOutputs[i]=pChecks+i*m_StripeUnitSize;
+    RunSchedule(m_EncodingSchedule,ppInputs,ppOutputs,ThreadID);
+    //send check symbols to disk
+    for(unsigned i=0;i<m_Redundancy;i++)
+        if (!IsErased(ErasureSetID,m_Dimension+i))
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,ppOutputs[i]);
+
+    return Result;
+};
+
+/**update some information symbols and the corresponding check symbols
+This will fetch the old values of the symbols to be updated and of the check symbols,
+and add to each check packet the data difference packets selected by the binary matrix
+   @return true on success
+   */
+bool CCauchyProcessor::UpdateInformationSymbols(unsigned long long StripeID,///the stripe to be updated,
+    unsigned ErasureSetID,///identifies the load balancing offset
+    unsigned StripeUnitID,///the first stripe unit to be updated
+    unsigned Units2Update,///the number of units to be updated
+    const unsigned char* pData,///new payload data symbols
+    size_t ThreadID ///the ID of the calling thread
+    )
+{
+    //assume here that there are no erased information symbols
+    unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    const unsigned char** ppSources=m_ppXORSources+ThreadID*16*m_Length;
+    bool Result=true;
+    //find the differences between new and old values
+    for(unsigned i=0;i<Units2Update;i++)
+    {
+        Result&=ReadStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pFetchBuffer+i*m_StripeUnitSize);
+        XOR(pFetchBuffer+i*m_StripeUnitSize,pData+i*m_StripeUnitSize,m_StripeUnitSize);
+    };
+    unsigned Columns=Extension*m_Dimension;
+    for(unsigned i=0;i<m_Redundancy;i++)
+    {
+        if (IsErased(ErasureSetID,m_Dimension+i))
+            //no need to update this symbol
+            continue;
+        unsigned char* pCheck=pFetchBuffer+(Units2Update+i)*m_StripeUnitSize;
+        Result&=ReadStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pCheck);
+        for(unsigned r=0;r<Extension;r++)
+        {
+            const unsigned char* pRow=m_pBitMatrix+(i*Extension+r)*Columns+StripeUnitID*Extension;
+            unsigned n=0;
+            ppSources[n++]=pCheck+r*m_PacketSize;
+            for(unsigned c=0;c<Units2Update*Extension;c++)
+                if (pRow[c])
+                    ppSources[n++]=pFetchBuffer+c*m_PacketSize;
+            XORN(pCheck+r*m_PacketSize,ppSources,n,m_PacketSize);
+        };
+    };
+    //save the new values
+    for(unsigned i=0;i<Units2Update;i++)
+        Result&=WriteStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pData+i*m_StripeUnitSize);
+    for(unsigned i=0;i<m_Redundancy;i++)
+        if (!IsErased(ErasureSetID,m_Dimension+i))
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer+(Units2Update+i)*m_StripeUnitSize);
+
+    return Result;
+};
+
+/**
+   Fetch all codeword symbols, and check if each check packet equals the sum of the
+   information packets selected by the binary matrix
+*/
+bool CCauchyProcessor::CheckCodeword(unsigned long long StripeID,///the stripe to be checked
+                               unsigned ErasureSetID,///identifies the load balancing offset
+                               size_t ThreadID ///identifies the calling thread
+                              )
+{
+    if (GetNumOfErasures(ErasureSetID))
+        return true;
+    unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    const unsigned char** ppSources=m_ppXORSources+ThreadID*16*m_Length;
+    for(unsigned i=0;i<m_Length;i++)
+        if (!ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pFetchBuffer+i*m_StripeUnitSize)) return false;
+    unsigned Columns=Extension*m_Dimension;
+    for(unsigned i=0;i<Extension*m_Redundancy;i++)
+    {
+        const unsigned char* pRow=m_pBitMatrix+i*Columns;
+        unsigned n=0;
+        ppSources[n++]=pFetchBuffer+Columns*m_PacketSize+i*m_PacketSize;
+        for(unsigned c=0;c<Columns;c++)
+            if (pRow[c])
+                ppSources[n++]=pFetchBuffer+c*m_PacketSize;
+        if (!IsXORZero(ppSources,n,m_PacketSize))
+            return false;
+    };
+    return true;
+};
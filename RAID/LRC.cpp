@@ -0,0 +1,498 @@
+/*********************************************************
+ * LRC.cpp  - implementation for a local reconstruction code based RAID
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include <algorithm>
+#include <string.h>
+#include "misc.h"
+#include "LRC.h"
+
+using namespace std;
+//the code is defined over GF(2^8)
+#define Extension 8
+//the maximal code length
+const unsigned LRCLength=1u<<Extension;
+
+///@return the length of the code: the information symbols, one local parity per group, and the global parities
+static unsigned GetLRCLength(const LRCParams* pParams)
+{
+    if (!pParams->GroupSize||pParams->GroupSize>pParams->CodeDimension)
+        throw Exception("Invalid local group size %d",pParams->GroupSize);
+    return pParams->CodeDimension+(pParams->CodeDimension+pParams->GroupSize-1)/pParams->GroupSize+pParams->GlobalRedundancy;
+};
+
+/**Initialize the global check symbol coefficients C_{ij}=1/(x_i+y_j), x_i=i, y_j=g+j.
+They are not normalized to make some row all-one, since such a row would be the sum of the local parities*/
+CLRCProcessor::CLRCProcessor(LRCParams* pParams):
+                CRAIDProcessor(GetLRCLength(pParams),1,pParams,sizeof(LRCParams)),
+                    m_GroupSize(pParams->GroupSize),m_GlobalRedundancy(pParams->GlobalRedundancy),
+                    m_pPlans(0),m_pSymbols(0),m_pParities(0),m_pUpdateCoefficients(0)
+{
+    if (m_Length>LRCLength)
+        throw Exception("LRC length exceeds %d",LRCLength);
+    if (m_StripeUnitSize%ARITHMETIC_ALIGNMENT)
+        throw Exception("Stripe unit size must be a multiple of %d",ARITHMETIC_ALIGNMENT);
+    m_NumOfGroups=(m_Dimension+m_GroupSize-1)/m_GroupSize;
+
+    InitGF(Extension);
+
+    m_pGlobalCoefficients=new int[m_GlobalRedundancy*m_Dimension];
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        for(unsigned j=0;j<m_Dimension;j++)
+            m_pGlobalCoefficients[i*m_Dimension+j]=LogTable[singleInverse(i^(m_GlobalRedundancy+j))];
+};
+
+CLRCProcessor::~CLRCProcessor()
+{
+    delete[]m_pGlobalCoefficients;
+    delete[]m_pPlans;
+    delete[]m_pUpdateCoefficients;
+    AlignedFree(m_pSymbols);
+    AlignedFree(m_pParities);
+};
+
+/**
+Allocate memory for fetched symbols, global check symbols and update coefficients
+return true on success
+*/
+bool CLRCProcessor::Attach(CDiskArray* pArray,///the disk array
+                        unsigned ConcurrentThreads ///the number of concurrent processing threads that will make calls to the processor
+                       )
+{
+    m_pSymbols=AlignedMalloc(m_Length*m_StripeUnitSize*ConcurrentThreads);
+    m_pParities=AlignedMalloc(max(m_GlobalRedundancy,1u)*m_StripeUnitSize*ConcurrentThreads);
+    m_pUpdateCoefficients=new int[m_GlobalRedundancy*m_Length*ConcurrentThreads];
+    m_pPlans=new RecoveryPlan[m_Length*m_InterleavingOrder];
+    return CRAIDProcessor::Attach(pArray,ConcurrentThreads);
+};
+
+/**Erased information symbols are recovered locally if they are the only erasure within
+their group. Otherwise select k surviving symbols, which determine the information symbols,
+and express the remaining erased information symbols via them
+@return true if the specified combination of erasures is correctable
+*/
+bool CLRCProcessor::IsCorrectable(unsigned ErasureSetID///identifies the erasure combination. This will not exceed m_Length-1
+                              )
+{
+    RecoveryPlan& Plan=m_pPlans[ErasureSetID];
+    Plan.GroupErasures.assign(m_NumOfGroups,0);
+    Plan.Sources.clear();
+    Plan.Targets.clear();
+    Plan.Coefficients.clear();
+    for(unsigned i=0;i<m_Dimension;i++)
+        if (IsErased(ErasureSetID,i))
+            Plan.GroupErasures[GetGroup(i)]++;
+    for(unsigned i=0;i<m_NumOfGroups;i++)
+        if (IsErased(ErasureSetID,m_Dimension+i))
+            Plan.GroupErasures[i]++;
+    for(unsigned i=0;i<m_Dimension;i++)
+        if (IsErased(ErasureSetID,i)&&!IsLocallyRecoverable(ErasureSetID,i))
+            Plan.Targets.push_back(i);
+    if (Plan.Targets.empty())
+        return true;
+
+    //select linearly independent surviving symbols. Prefer the information symbols, since they
+    //may be requested by the caller anyway, and then the local parities
+    unsigned k=m_Dimension;
+    //reduced rows of the selected symbols. Row s has a unit entry at column Pivots[s]
+    vector<GFValue> Basis(k*k);
+    vector<unsigned> Pivots;
+    vector<GFValue> Row(k);
+    for(unsigned i=0;i<m_Length&&Plan.Sources.size()<k;i++)
+    {
+        if (IsErased(ErasureSetID,i))
+            continue;
+        if (i<k)
+        {
+            //a surviving information symbol cannot depend on the other selected ones
+            Plan.Sources.push_back(i);
+            continue;
+        };
+        //express the check symbol via the information symbols
+        fill(Row.begin(),Row.end(),0);
+        if (i<k+m_NumOfGroups)
+        {
+            unsigned G=i-k;
+            for(unsigned j=G*m_GroupSize;j<G*m_GroupSize+GetGroupLength(G);j++)
+                Row[j]=1;
+        }else
+        {
+            const int* pRow=m_pGlobalCoefficients+(i-k-m_NumOfGroups)*k;
+            for(unsigned j=0;j<k;j++)
+                Row[j]=GF[1+pRow[j]];
+        };
+        //eliminate the surviving information symbols and the selected check symbols
+        for(unsigned j=0;j<k;j++)
+            if (!IsErased(ErasureSetID,j))
+                Row[j]=0;
+        for(unsigned s=0;s<Pivots.size();s++)
+        {
+            GFValue F=Row[Pivots[s]];
+            if (F)
+                for(unsigned j=0;j<k;j++)
+                    Row[j]^=singleMult(F,Basis[s*k+j],Extension);
+        };
+        unsigned P=0;
+        while (P<k&&!Row[P])
+            P++;
+        if (P==k)
+            //linearly dependent
+            continue;
+        GFValue D=singleInverse(Row[P]);
+        for(unsigned j=0;j<k;j++)
+            Basis[Pivots.size()*k+j]=singleMult(Row[j],D,Extension);
+        Pivots.push_back(P);
+        Plan.Sources.push_back(i);
+    };
+    if (Plan.Sources.size()<k)
+        return false;
+
+    //invert the matrix expressing the sources via the information symbols
+    vector<GFValue> A(k*k,0);
+    vector<GFValue> Inv(k*k,0);
+    for(unsigned s=0;s<k;s++)
+    {
+        unsigned S=Plan.Sources[s];
+        if (S<k)
+            A[s*k+S]=1;
+        else if (S<k+m_NumOfGroups)
+        {
+            unsigned G=S-k;
+            for(unsigned j=G*m_GroupSize;j<G*m_GroupSize+GetGroupLength(G);j++)
+                A[s*k+j]=1;
+        }else
+        {
+            const int* pRow=m_pGlobalCoefficients+(S-k-m_NumOfGroups)*k;
+            for(unsigned j=0;j<k;j++)
+                A[s*k+j]=GF[1+pRow[j]];
+        };
+    };
+    if (!InvertGFMatrix(&A[0],&Inv[0],k))
+        return false;
+    Plan.Coefficients.resize(Plan.Targets.size()*k);
+    for(unsigned t=0;t<Plan.Targets.size();t++)
+        for(unsigned s=0;s<k;s++)
+            Plan.Coefficients[t*k+s]=LogTable[Inv[Plan.Targets[t]*k+s]];
+    return true;
+};
+
+/**The locally recoverable symbols need the other symbols of their group and its local parity.
+The other ones need the global recovery sources
+*/
+void CLRCProcessor::GetRecoverySources(unsigned ErasureSetID,///identifies the erasure combination
+                                       unsigned SymbolID,///the first symbol to be recovered
+                                       unsigned NumOfSymbols,///the number of symbols
+                                       bool* pNeeded ///m_Length flags, which are set for the needed symbols
+                                      )const
+{
+    const RecoveryPlan& Plan=m_pPlans[ErasureSetID];
+    bool NeedsGlobal=false;
+    for(unsigned i=SymbolID;i<SymbolID+NumOfSymbols;i++)
+    {
+        if (!IsErased(ErasureSetID,i))
+            continue;
+        if (IsLocallyRecoverable(ErasureSetID,i))
+        {
+            unsigned G=GetGroup(i);
+            for(unsigned j=G*m_GroupSize;j<G*m_GroupSize+GetGroupLength(G);j++)
+                if (j!=i)
+                    pNeeded[j]=true;
+            pNeeded[m_Dimension+G]=true;
+        }else
+            NeedsGlobal=true;
+    };
+    if (NeedsGlobal)
+        for(unsigned j=0;j<m_Dimension;j++)
+            pNeeded[Plan.Sources[j]]=true;
+};
+
+/**
+Fetch the non-erased symbols as is. The requested erased symbols are recovered either
+as the XOR of the rest of their local group, or from the global recovery sources
+in a single pass over them
+*/
+bool CLRCProcessor::DecodeDataSymbols(unsigned long long StripeID,///the stripe to be processed
+                                  unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned SymbolID,///the first symbol to be processed
+                                  unsigned Symbols2Decode,///the number of subsymbols within this symbol to be decoded
+                                  unsigned char* pDest, ///destination array. Must have size at least Subsymbols2Decode*m_StripeUnitSize
+                                  size_t ThreadID ///the ID of the calling thread
+                                 )
+{
+    bool NeedsDecoding=false;
+    for(unsigned i=0;i<Symbols2Decode;i++)
+    {
+        if (IsErased(ErasureSetID,SymbolID+i))
+            NeedsDecoding=true;
+        else
+        {
+            //fetch it
+            if (!ReadStripeUnit(StripeID,ErasureSetID,SymbolID+i,0,1,pDest+i*m_StripeUnitSize))
+                return false;
+        };
+    };
+    if (!NeedsDecoding)
+        return true;
+    unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    bool Needed[LRCLength];
+    memset(Needed,0,sizeof(Needed));
+    GetRecoverySources(ErasureSetID,SymbolID,Symbols2Decode,Needed);
+    //fetch the needed symbols, which are not available yet
+    const GFValue* ppSymbols[LRCLength];
+    for(unsigned i=0;i<m_Length;i++)
+    {
+        if (!Needed[i])
+            continue;
+        if (i>=SymbolID&&i<SymbolID+Symbols2Decode)
+            //it has been already fetched
+            ppSymbols[i]=pDest+(i-SymbolID)*m_StripeUnitSize;
+        else
+        {
+            ppSymbols[i]=pFetchBuffer+i*m_StripeUnitSize;
+            if (!ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pFetchBuffer+i*m_StripeUnitSize))
+                return false;
+        };
+    };
+    //local recovery
+    const GFValue* ppSources[LRCLength];
+    for(unsigned i=SymbolID;i<SymbolID+Symbols2Decode;i++)
+    {
+        if (!IsErased(ErasureSetID,i)||!IsLocallyRecoverable(ErasureSetID,i))
+            continue;
+        unsigned G=GetGroup(i);
+        unsigned n=0;
+        for(unsigned j=G*m_GroupSize;j<G*m_GroupSize+GetGroupLength(G);j++)
+            if (j!=i)
+                ppSources[n++]=ppSymbols[j];
+        ppSources[n++]=ppSymbols[m_Dimension+G];
+        XORN(pDest+(i-SymbolID)*m_StripeUnitSize,ppSources,n,m_StripeUnitSize);
+    };
+    //global recovery. The requested targets are consecutive
+    const RecoveryPlan& Plan=m_pPlans[ErasureSetID];
+    unsigned First=0;
+    while (First<Plan.Targets.size()&&Plan.Targets[First]<SymbolID)
+        First++;
+    GFValue* ppValues[LRCLength];
+    unsigned Points=0;
+    while (First+Points<Plan.Targets.size()&&Plan.Targets[First+Points]<SymbolID+Symbols2Decode)
+    {
+        ppValues[Points]=pDest+(Plan.Targets[First+Points]-SymbolID)*m_StripeUnitSize;
+        Points++;
+    };
+    if (Points)
+    {
+        for(unsigned j=0;j<m_Dimension;j++)
+            ppSources[j]=ppSymbols[Plan.Sources[j]];
+        DotProduct(ppSources,m_Dimension,&Plan.Coefficients[First*m_Dimension],ppValues,Points,m_StripeUnitSize);
+    };
+    return true;
+};
+
+/**The recovery sources are the symbols marked by GetRecoverySources: the rest of the local group
+for an erased symbol recoverable within it, and the global sources otherwise
+*/
+unsigned CLRCProcessor::GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                    unsigned StripeUnitID,///the first stripe unit to be read
+                                    unsigned NumOfUnits,///the number of units to be read
+                                    size_t ThreadID ///the ID of the calling thread
+                                   )
+{
+    bool Needed[LRCLength];
+    memset(Needed,0,sizeof(Needed));
+    GetRecoverySources(ErasureSetID,StripeUnitID,NumOfUnits,Needed);
+    unsigned Sources[LRCLength];
+    unsigned NumOfSources=0;
+    for(unsigned i=0;i<m_Length;i++)
+        if (Needed[i])
+            Sources[NumOfSources++]=i;
+    return GetRecoveryReadCost(ErasureSetID,StripeUnitID,NumOfUnits,Sources,NumOfSources);
+};
+
+/**The local parities of the groups not affected by the update are not touched
+*/
+bool CLRCProcessor::GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                  unsigned StripeUnitID,///the first stripe unit to be updated
+                                  unsigned Units2Update,///the number of units to be updated
+                                  IOCost& Cost,///receives the cost
+                                  size_t ThreadID ///the ID of the calling thread
+                                 )
+{
+    for(unsigned i=StripeUnitID;i<StripeUnitID+Units2Update;i++)
+        if (IsErased(ErasureSetID,i))
+            return false;
+    unsigned CheckUnits=0;
+    for(unsigned G=GetGroup(StripeUnitID);G<=GetGroup(StripeUnitID+Units2Update-1);G++)
+        CheckUnits+=!IsErased(ErasureSetID,m_Dimension+G);
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        CheckUnits+=!IsErased(ErasureSetID,m_Dimension+m_NumOfGroups+i);
+    //the old data is not needed if there is nothing to update
+    Cost.Reads=(CheckUnits)?Units2Update+CheckUnits:0;
+    Cost.Writes=Units2Update+CheckUnits;
+    return true;
+};
+
+/**encode and write the whole stripe.
+The local parities are computed by XOR, and the global ones in a single pass over the data
+@return true on success
+*/
+bool CLRCProcessor::EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
+                              unsigned ErasureSetID,///identifies the load balancing offset
+                              const unsigned char* pData,///the data to be envoced
+                              size_t ThreadID ///the ID of the calling thread
+                 )
+{
+    bool Result=true;
+    const GFValue* ppData[LRCLength];
+    for(unsigned i=0;i<m_Dimension;i++)
+    {
+        ppData[i]=pData+i*m_StripeUnitSize;
+        //send the data to disk
+        if (!IsErased(ErasureSetID,i))
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,i,0,1,pData+i*m_StripeUnitSize);
+    };
+    //use the fetch buffer as a temporary storage for the local parities
+    unsigned char* pLocal=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    for(unsigned G=0;G<m_NumOfGroups;G++)
+    {
+        if (IsErased(ErasureSetID,m_Dimension+G))
+            continue;
+        XORN(pLocal,ppData+G*m_GroupSize,GetGroupLength(G),m_StripeUnitSize);
+        Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+G,0,1,pLocal);
+    };
+    GFValue* ppValues[LRCLength];
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        ppValues[i]=m_pParities+(ThreadID*m_GlobalRedundancy+i)*m_StripeUnitSize;
+    DotProduct(ppData,m_Dimension,m_pGlobalCoefficients,ppValues,m_GlobalRedundancy,m_StripeUnitSize);
+    //send check symbols to disk
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        if (!IsErased(ErasureSetID,m_Dimension+m_NumOfGroups+i))
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+m_NumOfGroups+i,0,1,ppValues[i]);
+
+    return Result;
+};
+
+/**update some information symbols and the corresponding check symbols
+This will fetch the old values of the symbols to be updated, the local parities of the affected groups
+and the global parities. The local parities are updated by XOR, and the global ones in a single pass
+over the data differences and the old global parities
+   @return true on success
+   */
+bool CLRCProcessor::UpdateInformationSymbols(unsigned long long StripeID,///the stripe to be updated,
+    unsigned ErasureSetID,///identifies the load balancing offset
+    unsigned StripeUnitID,///the first stripe unit to be updated
+    unsigned Units2Update,///the number of units to be updated
+    const unsigned char* pData,///new payload data symbols
+    size_t ThreadID ///the ID of the calling thread
+    )
+{
+    //assume here that there are no erased information symbols
+    unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    bool Result=true;
+    unsigned FirstGroup=GetGroup(StripeUnitID);
+    unsigned LastGroup=GetGroup(StripeUnitID+Units2Update-1);
+    unsigned Checks[LRCLength];
+    unsigned NumOfChecks=0;
+    for(unsigned G=FirstGroup;G<=LastGroup;G++)
+        if (!IsErased(ErasureSetID,m_Dimension+G))
+            Checks[NumOfChecks++]=m_Dimension+G;
+    unsigned NumOfLocalChecks=NumOfChecks;
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        if (!IsErased(ErasureSetID,m_Dimension+m_NumOfGroups+i))
+            Checks[NumOfChecks++]=m_Dimension+m_NumOfGroups+i;
+    if (NumOfChecks)
+    {
+        //fetch the old data and the check symbols to be updated
+        const GFValue* ppData[LRCLength];
+        for(unsigned i=0;i<Units2Update;i++)
+        {
+            ppData[i]=pFetchBuffer+i*m_StripeUnitSize;
+            Result&=ReadStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pFetchBuffer+i*m_StripeUnitSize);
+        };
+        for(unsigned j=0;j<NumOfChecks;j++)
+        {
+            ppData[Units2Update+j]=pFetchBuffer+(Units2Update+j)*m_StripeUnitSize;
+            Result&=ReadStripeUnit(StripeID,ErasureSetID,Checks[j],0,1,pFetchBuffer+(Units2Update+j)*m_StripeUnitSize);
+        };
+        //find the differences between new and old values
+        for(unsigned i=0;i<Units2Update;i++)
+            XOR(pFetchBuffer+i*m_StripeUnitSize,pData+i*m_StripeUnitSize,m_StripeUnitSize);
+        //add the differences within each group to its local parity
+        const GFValue* ppSources[LRCLength];
+        for(unsigned j=0;j<NumOfLocalChecks;j++)
+        {
+            unsigned G=Checks[j]-m_Dimension;
+            unsigned char* pCheck=pFetchBuffer+(Units2Update+j)*m_StripeUnitSize;
+            unsigned n=0;
+            ppSources[n++]=pCheck;
+            for(unsigned i=max(StripeUnitID,G*m_GroupSize);i<min(StripeUnitID+Units2Update,G*m_GroupSize+GetGroupLength(G));i++)
+                ppSources[n++]=ppData[i-StripeUnitID];
+            XORN(pCheck,ppSources,n,m_StripeUnitSize);
+        };
+        //new global parity j is the old one plus the encoded differences
+        unsigned NumOfGlobalChecks=NumOfChecks-NumOfLocalChecks;
+        unsigned k=Units2Update+NumOfGlobalChecks;
+        for(unsigned j=0;j<NumOfGlobalChecks;j++)
+            ppData[Units2Update+j]=ppData[Units2Update+NumOfLocalChecks+j];
+        int* pCoefficients=m_pUpdateCoefficients+ThreadID*m_GlobalRedundancy*m_Length;
+        GFValue* ppValues[LRCLength];
+        for(unsigned j=0;j<NumOfGlobalChecks;j++)
+        {
+            const int* pRow=m_pGlobalCoefficients+(Checks[NumOfLocalChecks+j]-m_Dimension-m_NumOfGroups)*m_Dimension+StripeUnitID;
+            for(unsigned i=0;i<Units2Update;i++)
+                pCoefficients[j*k+i]=pRow[i];
+            for(unsigned i=0;i<NumOfGlobalChecks;i++)
+                pCoefficients[j*k+Units2Update+i]=(i==j)?0:-1;
+            ppValues[j]=m_pParities+(ThreadID*m_GlobalRedundancy+j)*m_StripeUnitSize;
+        };
+        DotProduct(ppData,k,pCoefficients,ppValues,NumOfGlobalChecks,m_StripeUnitSize);
+        for(unsigned j=0;j<NumOfChecks;j++)
+            Result&=WriteStripeUnit(StripeID,ErasureSetID,Checks[j],0,1,
+                                    (j<NumOfLocalChecks)?pFetchBuffer+(Units2Update+j)*m_StripeUnitSize:ppValues[j-NumOfLocalChecks]);
+    };
+    //save the new values
+    for(unsigned i=0;i<Units2Update;i++)
+        Result&=WriteStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pData+i*m_StripeUnitSize);
+
+    return Result;
+};
+
+/**
+   Fetch all codeword symbols, and check if the local and global parities are consistent with the data
+*/
+bool CLRCProcessor::CheckCodeword(unsigned long long StripeID,///the stripe to be checked
+                               unsigned ErasureSetID,///identifies the load balancing offset
+                               size_t ThreadID ///identifies the calling thread
+                              )
+{
+    if (GetNumOfErasures(ErasureSetID))
+        return true;
+    unsigned char* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
+    const GFValue* ppData[LRCLength];
+    for(unsigned i=0;i<m_Length;i++)
+    {
+        ppData[i]=pFetchBuffer+i*m_StripeUnitSize;
+        if (!ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pFetchBuffer+i*m_StripeUnitSize)) return false;
+    };
+    const GFValue* ppSources[LRCLength];
+    for(unsigned G=0;G<m_NumOfGroups;G++)
+    {
+        unsigned n=GetGroupLength(G);
+        memcpy(ppSources,ppData+G*m_GroupSize,n*sizeof(GFValue*));
+        ppSources[n++]=ppData[m_Dimension+G];
+        if (!IsXORZero(ppSources,n,m_StripeUnitSize))
+            return false;
+    };
+    GFValue* ppValues[LRCLength];
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        ppValues[i]=m_pParities+(ThreadID*m_GlobalRedundancy+i)*m_StripeUnitSize;
+    DotProduct(ppData,m_Dimension,m_pGlobalCoefficients,ppValues,m_GlobalRedundancy,m_StripeUnitSize);
+    for(unsigned i=0;i<m_GlobalRedundancy;i++)
+        if (!Equal(ppValues[i],ppData[m_Dimension+m_NumOfGroups+i],m_StripeUnitSize))
+            return false;
+    return true;
+};
@@ -18,7 +18,7 @@ using namespace std;
 
 ///initialize coding-related parameters
 CRAID5Processor::CRAID5Processor(RAID5Params* P ///the configuration file
-                                ):CRAIDProcessor(P->CodeDimension+1, 1,P,sizeof(*P)),m_pXORBuffer(0)
+                                ):CRAIDProcessor(P->CodeDimension+1, 1,P,sizeof(*P)),m_pXORBuffer(0),m_ppXORSources(0)
 {
     if (m_StripeUnitSize%ARITHMETIC_ALIGNMENT)
         throw Exception("Stripe size must be a multiple of #ARITHMETIC_ALIGNMENT");
@@ -27,7 +27,8 @@ CRAID5Processor::CRAID5Processor(RAID5Params* P ///the configuration file
 
 CRAID5Processor::~CRAID5Processor()
 {
-    AlignedFree(m_pXORBuffer);;
+    AlignedFree(m_pXORBuffer);
+    delete[]m_ppXORSources;
 };
 
 
@@ -39,7 +40,8 @@ bool CRAID5Processor::Attach(CDiskArray* pArray,///the disk array
                             )
 {
 
-    m_pXORBuffer=AlignedMalloc(ConcurrentThreads*m_StripeUnitSize*2);
+    m_pXORBuffer=AlignedMalloc(ConcurrentThreads*m_StripeUnitSize*m_Length);
+    m_ppXORSources=new const unsigned char*[ConcurrentThreads*2*m_Length];
     return CRAIDProcessor::Attach(pArray,ConcurrentThreads);
 };
 
@@ -69,30 +71,23 @@ bool CRAID5Processor::DecodeDataSymbols(unsigned long long StripeID,///the strip
     {
         //read all symbols and XOR them to obtain the erased one
         unsigned S=GetErasedPosition(ErasureSetID,0);
-        unsigned i=(S==0)?1:0;
-        unsigned char* pXORBuffer=pDest+(S-SymbolID)*m_StripeUnitSize;
-        unsigned char* pReadBuffer=m_pXORBuffer+(ThreadID*2+1)*m_StripeUnitSize;
-        //the first symbol can be loaded directly to the buffer
-        Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pXORBuffer);
-        if ((i>=SymbolID)&&(i<SymbolID+Symbols2Decode))
-            memcpy(pDest+(i-SymbolID)*m_StripeUnitSize,pXORBuffer,m_StripeUnitSize);
-        i++;
-        for (;i<m_Length;i++)
+        unsigned char* pReadBuffer=m_pXORBuffer+ThreadID*m_Length*m_StripeUnitSize;
+        const unsigned char** ppSources=m_ppXORSources+ThreadID*2*m_Length;
+        unsigned n=0;
+        for (unsigned i=0;i<m_Length;i++)
         {
             if (i==S) continue;
+            unsigned char* pCurDest;
             if ((i>=SymbolID)&&(i<SymbolID+Symbols2Decode))
-            {
                 //this is a payload symbol which has to be read
-                unsigned char* pCurDest=pDest+(i-SymbolID)*m_StripeUnitSize;
-                Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pCurDest);
-                XOR(pXORBuffer,pCurDest,m_StripeUnitSize);
-            } else
-            {
+                pCurDest=pDest+(i-SymbolID)*m_StripeUnitSize;
+            else
                 //this symbol is needed only to compute the checksum
-                Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer);
-                XOR(pXORBuffer,pReadBuffer,m_StripeUnitSize);
-            };
+                pCurDest=pReadBuffer+i*m_StripeUnitSize;
+            Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pCurDest);
+            ppSources[n++]=pCurDest;
         };
+        XORN(pDest+(S-SymbolID)*m_StripeUnitSize,ppSources,n,m_StripeUnitSize);
         //the erased symbol is now recovered
         return Result;
     };
@@ -109,24 +104,20 @@ bool CRAID5Processor::EncodeStripe(unsigned long long StripeID,///the stripe to
                                   )
 {
 
-    unsigned char* pXORBuffer=m_pXORBuffer+ThreadID*2*m_StripeUnitSize;
+    unsigned char* pXORBuffer=m_pXORBuffer+ThreadID*m_Length*m_StripeUnitSize;
+    const unsigned char** ppSources=m_ppXORSources+ThreadID*2*m_Length;
 
     bool Result=true;
-    if (!IsErased(ErasureSetID,0))
-    {
-        Result&=WriteStripeUnit(StripeID,ErasureSetID,0,0,1,pData);
-    };
-    memcpy(pXORBuffer,pData,m_StripeUnitSize);
-    pData+=m_StripeUnitSize;
-    for (unsigned i=1;i<m_Dimension;i++)
+    for (unsigned i=0;i<m_Dimension;i++)
     {
         if (!IsErased(ErasureSetID,i))
         {
             Result&=WriteStripeUnit(StripeID,ErasureSetID,i,0,1,pData);
         };
-        XOR(pXORBuffer,pData,m_StripeUnitSize);
+        ppSources[i]=pData;
         pData+=m_StripeUnitSize;
     };
+    XORN(pXORBuffer,ppSources,m_Dimension,m_StripeUnitSize);
     //write the parity symbol
     if (!IsErased(ErasureSetID,m_Dimension))
     {
@@ -160,8 +151,11 @@ bool CRAID5Processor::UpdateInformationSymbols(unsigned long long StripeID,///th
     } else
     {
         //the parity check symbol has to be updated
-        unsigned char* pXORBuffer=m_pXORBuffer+ThreadID*2*m_StripeUnitSize;
-        unsigned char* pReadBuffer=m_pXORBuffer+(ThreadID*2+1)*m_StripeUnitSize;
+        //symbol i is read into the i-th unit of the buffer, and the new parity symbol is placed into its last unit
+        unsigned char* pReadBuffer=m_pXORBuffer+ThreadID*m_Length*m_StripeUnitSize;
+        unsigned char* pXORBuffer=pReadBuffer+m_Dimension*m_StripeUnitSize;
+        const unsigned char** ppSources=m_ppXORSources+ThreadID*2*m_Length;
+        unsigned n=0;
         unsigned S=GetErasedPosition(ErasureSetID,0);
         if ((S>=StripeUnitID)&&(S<StripeUnitID+Units2Update))
         {
@@ -169,40 +163,38 @@ bool CRAID5Processor::UpdateInformationSymbols(unsigned long long StripeID,///th
             //the updated parity check value is given by \sum_{i\not \in U} A_i +\sum_{i\in U} A_i'
             //U is the set of symbols to be updated, A_i are the old symbol values,
             //A_i' are the new symbol values
-            memset(pXORBuffer,0,m_StripeUnitSize);
             //process the symbols not to be updated
-            for (unsigned i=0;i<StripeUnitID;i++)
-            {
-                Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer);
-                XOR(pXORBuffer,pReadBuffer,m_StripeUnitSize);
-            };
-            for (unsigned i=StripeUnitID+Units2Update;i<m_Dimension;i++)
+            for (unsigned i=0;i<m_Dimension;i++)
             {
-                Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer);
-                XOR(pXORBuffer,pReadBuffer,m_StripeUnitSize);
+                if ((i>=StripeUnitID)&&(i<StripeUnitID+Units2Update))
+                    continue;
+                Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer+i*m_StripeUnitSize);
+                ppSources[n++]=pReadBuffer+i*m_StripeUnitSize;
             };
             //process the symbols to be updated
             for (unsigned i=0;i<Units2Update;i++)
             {
-                XOR(pXORBuffer,pData+i*m_StripeUnitSize,m_StripeUnitSize);
+                ppSources[n++]=pData+i*m_StripeUnitSize;
                 if (S==StripeUnitID+i)
                     continue;//we cannot write to the failed disk
                 else
                     Result&=WriteStripeUnit(StripeID,ErasureSetID,i+StripeUnitID,0,1,pData+i*m_StripeUnitSize);
             };
-
+            XORN(pXORBuffer,ppSources,n,m_StripeUnitSize);
         } else
         {
             //the updated parity check value is given by S'=S +\sum_{i\in U} A_i'
             //load the old parity check symbol
             Result&=ReadStripeUnit(StripeID,ErasureSetID,m_Dimension,0,1,pXORBuffer);
+            ppSources[n++]=pXORBuffer;
             for (unsigned i=0;i<Units2Update;i++)
             {
-                XOR(pXORBuffer,pData+i*m_StripeUnitSize,m_StripeUnitSize);
-                Result&=ReadStripeUnit(StripeID,ErasureSetID,i+StripeUnitID,0,1,pReadBuffer);
-                XOR(pXORBuffer,pReadBuffer,m_StripeUnitSize);
+                ppSources[n++]=pData+i*m_StripeUnitSize;
+                Result&=ReadStripeUnit(StripeID,ErasureSetID,i+StripeUnitID,0,1,pReadBuffer+i*m_StripeUnitSize);
+                ppSources[n++]=pReadBuffer+i*m_StripeUnitSize;
                 Result&=WriteStripeUnit(StripeID,ErasureSetID,i+StripeUnitID,0,1,pData+i*m_StripeUnitSize);
             };
+            XORN(pXORBuffer,ppSources,n,m_StripeUnitSize);
         };
         Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension,0,1,pXORBuffer);
     };
@@ -210,6 +202,36 @@ bool CRAID5Processor::UpdateInformationSymbols(unsigned long long StripeID,///th
 
 };
 
+/** The parity symbol is either updated using the old values of the data symbols, or, if one of them is
+ * erased, recomputed from the new data and the unaffected data symbols
+ */
+bool CRAID5Processor::GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                    unsigned StripeUnitID,///the first stripe unit to be updated
+                                    unsigned Units2Update,///the number of units to be updated
+                                    IOCost& Cost,///receives the cost
+                                    size_t ThreadID ///the ID of the calling thread
+                                   )
+{
+    if (IsErased(ErasureSetID,m_Dimension))
+    {
+        Cost.Reads=0;
+        Cost.Writes=Units2Update;
+        return true;
+    };
+    unsigned S=GetErasedPosition(ErasureSetID,0);
+    if ((S>=StripeUnitID)&&(S<StripeUnitID+Units2Update))
+    {
+        //the erased symbol is not written, but the parity symbol is
+        Cost.Reads=m_Dimension-Units2Update;
+        Cost.Writes=Units2Update;
+    } else
+    {
+        Cost.Reads=Units2Update+1;
+        Cost.Writes=Units2Update+1;
+    };
+    return true;
+};
+
 /** Check if the sum of all codeword symbols is equal zero
 * @return true on success
 */
@@ -221,22 +243,17 @@ bool CRAID5Processor::CheckCodeword(unsigned long long StripeID,///identifies th
     if (GetNumOfErasures(ErasureSetID))
         //there is no way to check it for consistency
         return true;
-    unsigned char* pXORBuffer=m_pXORBuffer+ThreadID*2*m_StripeUnitSize;
-    unsigned char* pReadBuffer=m_pXORBuffer+(1+ThreadID*2)*m_StripeUnitSize;
-    bool Result=ReadStripeUnit(StripeID,ErasureSetID,0,0,1,pXORBuffer);
-    for (unsigned i=1;i<m_Length;i++)
+    unsigned char* pReadBuffer=m_pXORBuffer+ThreadID*m_Length*m_StripeUnitSize;
+    const unsigned char** ppSources=m_ppXORSources+ThreadID*2*m_Length;
+    bool Result=true;
+    for (unsigned i=0;i<m_Length;i++)
     {
-        Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer);
-        XOR(pXORBuffer,pReadBuffer,m_StripeUnitSize);
+        Result&=ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pReadBuffer+i*m_StripeUnitSize);
+        ppSources[i]=pReadBuffer+i*m_StripeUnitSize;
     };
     if (!Result)
         return false;
     else
-    {
-        unsigned char S=0;
-        for (unsigned i=0;i<m_StripeUnitSize;i++)
-            S|=pXORBuffer[i];
-        return S==0;
-    };
+        return IsXORZero(ppSources,m_Length,m_StripeUnitSize);
 
 };
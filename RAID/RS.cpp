@@ -22,6 +22,9 @@ using namespace std;
 #define Extension 8
 //length of the parent code
 const unsigned RSLength=(1u<<Extension)-1;
+//the maximal number of outputs computed by a single DotProduct call.
+//This limits the size of the coefficient matrices kept on the stack
+#define DOT_PRODUCT_BATCH 8
 
 
 //compute X_i^{1-b}/\Lambda'(1/X_i) (needed by Forney algorithm)
@@ -64,9 +67,8 @@ setup check symbol locator polynomial*/
 CRSProcessor::CRSProcessor( RSParams* pParams):
                 CRAIDProcessor(pParams->CodeDimension+pParams->Redundancy,
 					1,pParams,sizeof(RSParams)),m_Redundancy(pParams->Redundancy),
-                    m_pErasureLocatorsPrime(0),
-					m_pSyndromes(0),m_pErasureEvaluator(0),m_pErasureLocators(0),
-                    m_pSymbols(0),m_ppSymbols(0),m_pCyclotomicTemp(0)
+					m_pSyndromes(0),m_pUpdateCoefficients(0),
+                    m_pSymbols(0),m_ppSymbols(0),m_ppSources(0)
 {
     if (m_Dimension>=m_Length)
         throw Exception("Dimension exceeds Reed-Solomon code length");
@@ -147,30 +149,19 @@ CRSProcessor::CRSProcessor( RSParams* pParams):
             };
      };
 
-    //construct the erasure locator polynomial for efficient encoding
-    m_pCheckLocator=new GFValue[m_Redundancy+1];
-    memset(m_pCheckLocator+1,0,sizeof(GFValue)*m_Redundancy);
-    m_pCheckLocator[0]=1;
-    ///\prod_i (1-xX_i)
-    for(unsigned i=0;i<m_Redundancy;i++)
-    {
-        for(unsigned j=i+1;j>0;j--)
-        {
-            if (m_pCheckLocator[j-1])
-            {
-                int L=LogTable[m_pCheckLocator[j-1]]+m_pCheckSymbols[i];
-                if (L>=FieldSize_1)
-                    L-=FieldSize_1;
-                m_pCheckLocator[j]^=GF[1+L];
-            };
-        };
-    };
-    m_pCheckLocatorsPrime=new int[m_Redundancy];
-    for(unsigned i=0;i<m_Redundancy;i++)
-        m_pCheckLocatorsPrime[i]=GetForneyMultiple(m_Redundancy,m_pCheckLocator,0,m_pCheckSymbols[i]);
+    unsigned NumOfErasureSets=m_Length*m_InterleavingOrder;
+    m_pRecoverySources=new unsigned[m_Dimension*NumOfErasureSets];
+    m_pRecoveryTargets=new unsigned[m_Redundancy*NumOfErasureSets];
+    m_pNumOfRecoveryTargets=new unsigned[NumOfErasureSets];
+    m_pRecoveryCoefficients=new int[m_Redundancy*m_Dimension*NumOfErasureSets];
 
-    m_pErasureLocators=new GFValue[(m_Redundancy+1)*m_Length*m_InterleavingOrder];
-    m_pErasureLocatorsPrime=new int[m_Redundancy*m_Length*m_InterleavingOrder];
+    //the check symbols are obtained from the information ones
+    unsigned* pSources=new unsigned[m_Length];
+    for(unsigned i=0;i<m_Length;i++)
+        pSources[i]=i;
+    m_pParityCoefficients=new int[m_Redundancy*m_Dimension];
+    GetRecoveryCoefficients(pSources,pSources+m_Dimension,m_Redundancy,m_pParityCoefficients);
+    delete[]pSources;
 
 };
 
@@ -179,20 +170,21 @@ CRSProcessor::~CRSProcessor()
 {
      delete[]m_pInfSymbols;
      delete[]m_pCheckSymbols;
-	 delete[]m_pCheckLocator;
-	 delete[]m_pErasureLocators;
+	 delete[]m_pRecoverySources;
+	 delete[]m_pRecoveryTargets;
+	 delete[]m_pNumOfRecoveryTargets;
+	 delete[]m_pRecoveryCoefficients;
 	 delete[]m_ppSymbols;
-     delete[]m_pErasureLocatorsPrime;
-     delete[]m_pCheckLocatorsPrime;
-	 AlignedFree(m_pErasureEvaluator);
+	 delete[]m_ppSources;
+	 delete[]m_pUpdateCoefficients;
+     delete[]m_pParityCoefficients;
 	 AlignedFree(m_pSyndromes);
 	 AlignedFree(m_pSymbols);
-     AlignedFree(m_pCyclotomicTemp);
 };
 
 
 /**
-Allocate memory for syndrome and erasure evaluator polynomials
+Allocate memory for syndromes, fetched symbols and check symbol update coefficients
 return true on success
 */
 bool CRSProcessor::Attach(CDiskArray* pArray,///the disk array
@@ -200,18 +192,13 @@ bool CRSProcessor::Attach(CDiskArray* pArray,///the disk array
                        )
 {
 	m_pSyndromes=AlignedMalloc(m_Redundancy*m_StripeUnitSize*ConcurrentThreads);
-	m_pErasureEvaluator=AlignedMalloc(m_Redundancy*m_StripeUnitSize*ConcurrentThreads);
 	m_pSymbols=AlignedMalloc(m_Length*m_StripeUnitSize*ConcurrentThreads);
-    if (m_CyclotomicProcessing)
-    {
-#ifndef STUDENTBUILD
-        m_pCyclotomicTemp=AlignedMalloc(sizeof(GFValue)*m_StripeUnitSize*ConcurrentThreads*CYCLOTOMIC_TEMP_SIZE);
-#endif
-    };
 
 
+	m_pUpdateCoefficients=new int[m_Redundancy*m_Length*ConcurrentThreads];
 	m_ppSymbols=new const GFValue*[RSLength*ConcurrentThreads];
 	memset(m_ppSymbols,0,RSLength*ConcurrentThreads*sizeof(GFValue*));
+	m_ppSources=new const GFValue*[m_Length*ConcurrentThreads];
 	return CRAIDProcessor::Attach(pArray,ConcurrentThreads);
 };
 ///reset the erasure correction engine
@@ -224,8 +211,8 @@ void CRSProcessor::ResetErasures()
 
 
 
-/**Construct the erasure locator polynomial for a given combination
-of erasures
+/**Select k surviving symbols for a given combination of erasures,
+and express the erased information symbols via them
 @return true if the specified combination of erasures is correctable
 */
 bool CRSProcessor::IsCorrectable(unsigned ErasureSetID///identifies the erasure combination. This will not exceed m_Length-1
@@ -233,52 +220,26 @@ bool CRSProcessor::IsCorrectable(unsigned ErasureSetID///identifies the erasure
 {
     if (GetNumOfErasures(ErasureSetID)==0) return true;
 	if (GetNumOfErasures(ErasureSetID)>m_Redundancy) return false;
-	//setup the erasure locator polynomial for decoding
-	GFValue* pLambda=m_pErasureLocators+ErasureSetID*(m_Redundancy+1);
-	pLambda[0]=1;
-	unsigned t=GetNumOfErasures(ErasureSetID);
-	memset(pLambda+1,0,sizeof(GFValue)*t);
-	//Lambda(x)=\prod_{i=0}^{t-1}(1-xX_i)
-	for(unsigned i=0;i<t;i++)
-	{
-		unsigned DiskID=GetErasedPosition(ErasureSetID,i);
-		//translate it into the locator value
-		int Locator;
-		if (DiskID<m_Dimension)
-			Locator=m_pInfSymbols[DiskID];
-		else
-			Locator=m_pCheckSymbols[DiskID-m_Dimension];
-		//multiply by (1-xX_i)
-		for(unsigned j=i+1;j>0;j--)
-		{
-			if (pLambda[j-1])
-			{
-				int L=LogTable[pLambda[j-1]]+Locator;
-				if (L>=FieldSize_1)
-					L-=FieldSize_1;
-				pLambda[j]^=GF[1+L];
-			};
-		};
-	};
-    //compute \alpha^{1-b}/\Lambda'(1/X_i) (needed by Forney algorithm)
-    int* pLambdaPrime=m_pErasureLocatorsPrime+ErasureSetID*m_Redundancy;
-    for(unsigned i=0;i<t;i++)
-    {
-		unsigned DiskID=GetErasedPosition(ErasureSetID,i);
-		int Locator;
-		if (DiskID<m_Dimension)
-			Locator=m_pInfSymbols[DiskID];
-		else
-			Locator=m_pCheckSymbols[DiskID-m_Dimension];
-        pLambdaPrime[i]=GetForneyMultiple(t,pLambda,0,Locator);
-    };
-
+    //prefer the information symbols, since they may be requested by the caller anyway
+    unsigned* pSources=m_pRecoverySources+ErasureSetID*m_Dimension;
+    unsigned k=0;
+    for(unsigned i=0;i<m_Length&&k<m_Dimension;i++)
+        if (!IsErased(ErasureSetID,i))
+            pSources[k++]=i;
+    unsigned* pTargets=m_pRecoveryTargets+ErasureSetID*m_Redundancy;
+    unsigned t=0;
+    for(unsigned i=0;i<m_Dimension;i++)
+        if (IsErased(ErasureSetID,i))
+            pTargets[t++]=i;
+    m_pNumOfRecoveryTargets[ErasureSetID]=t;
+    GetRecoveryCoefficients(pSources,pTargets,t,m_pRecoveryCoefficients+ErasureSetID*m_Redundancy*m_Dimension);
 	return true;
 };
 
 /** Compute 
 S_i=\sum_{j=0}^{n-1} y_j \alpha^{ij}, Low<=i<High.
-The operation will be performed for each of UnitSize words
+The operation will be performed for each of UnitSize words.
+Each batch of DOT_PRODUCT_BATCH syndromes is obtained in a single pass over the data
 */
 void ComputeSyndrome(const GFValue*const* ppData,///pointers to y_j. Each y_j is an array of size UnitSize. If ppData[i]=0, the symbols are assumed to be 0
                      GFValue* pSyndromes,/// S_i (packed). Each S_i is an array of size UnitSize
@@ -287,26 +248,32 @@ void ComputeSyndrome(const GFValue*const* ppData,///pointers to y_j. Each y_j is
                      unsigned UnitSize ///size of one data unit
                      )
 {
-    if (ppData[0])
+    //collect the non-zero symbols
+    const GFValue* ppSources[RSLength];
+    unsigned Positions[RSLength];
+    unsigned n=0;
+    for(unsigned j=0;j<RSLength;j++)
     {
-        for(unsigned i=0;i<High-Low;i++)
-            memcpy(pSyndromes+i*UnitSize,ppData[0],UnitSize*sizeof(GFValue));
-    }else memset(pSyndromes,0,UnitSize*(High-Low)*sizeof(GFValue));
-     
-    for(int i=1;i<RSLength;i++)
+        if (ppData[j])
+        {
+            ppSources[n]=ppData[j];
+            Positions[n]=j;
+            n++;
+        };
+    };
+    int Coefficients[DOT_PRODUCT_BATCH*RSLength];
+    GFValue* ppDest[DOT_PRODUCT_BATCH];
+    for(unsigned i0=Low;i0<High;i0+=DOT_PRODUCT_BATCH)
     {
-        if (ppData[i])
+        unsigned r=min(High-i0,(unsigned)DOT_PRODUCT_BATCH);
+        for(unsigned i=0;i<r;i++)
         {
-            int L1=(Low*i)%FieldSize_1;
-            for(unsigned j=0;j<High-Low;j++,L1+=i)
-            {
-                if (L1>=FieldSize_1)
-                    L1-=FieldSize_1;
-                MultiplyAdd(L1,ppData[i],pSyndromes+j*UnitSize,UnitSize);
-            };
+            ppDest[i]=pSyndromes+(i0+i-Low)*UnitSize;
+            for(unsigned l=0;l<n;l++)
+                Coefficients[i*n+l]=((i0+i)*Positions[l])%FieldSize_1;
         };
+        DotProduct(ppSources,n,Coefficients,ppDest,r,UnitSize);
     };
-
 };
 
 
@@ -322,47 +289,149 @@ void GetErasureEvaluator(const GFValue* pSyndromes,///S(x) stored blockwise
                          unsigned UnitSize///size of one data block
                          )
 {
-    for(unsigned i=0;i<MaxErrors;i++)
+    const GFValue* ppSources[RSLength];
+    for(unsigned j=0;j<MaxErrors;j++)
+        ppSources[j]=pSyndromes+j*UnitSize;
+    int Coefficients[DOT_PRODUCT_BATCH*RSLength];
+    GFValue* ppDest[DOT_PRODUCT_BATCH];
+    for(unsigned i0=0;i0<MaxErrors;i0+=DOT_PRODUCT_BATCH)
+    {
+        unsigned r=min(MaxErrors-i0,(unsigned)DOT_PRODUCT_BATCH);
+        //only S_0,...,S_{i0+r-1} contribute to this batch
+        unsigned k=i0+r;
+        for(unsigned i=0;i<r;i++)
+        {
+            ppDest[i]=pGamma+(i0+i)*UnitSize;
+            //\Gamma_i=\sum_{j=0}^i S_{i-j}\Lambda_j
+            for(unsigned l=0;l<k;l++)
+                Coefficients[i*k+l]=((l<=i0+i)&&pLambda[i0+i-l])?LogTable[pLambda[i0+i-l]]:-1;
+        };
+        DotProduct(ppSources,k,Coefficients,ppDest,r,UnitSize);
+    };
+};
+
+/** evaluate a block of polynomials at several points, and scale the results:
+V_i=\alpha^{s_i}\sum_{j=0}^{Degree} P_j\alpha^{x_i j}.
+This is the last step of the Forney algorithm. Each batch of DOT_PRODUCT_BATCH points
+is processed in a single pass over the polynomials
+*/
+void EvaluateScaled(const GFValue* pPolynomials,///polynomials stored blockwise
+                    unsigned Degree,///the degree of the polynomials
+                    unsigned Points,///the number of evaluation points
+                    const int* pX,///the polynomials will be evaluated at \alpha^{x_i}
+                    const int* pScale,///the values will be multiplied by \alpha^{s_i}
+                    GFValue* const* ppValues,///output will be placed here
+                    unsigned UnitSize ///the number of polynomials to be evaluated (i.e. block size)
+                    )
+{
+    const GFValue* ppSources[RSLength];
+    for(unsigned j=0;j<=Degree;j++)
+        ppSources[j]=pPolynomials+j*UnitSize;
+    int Coefficients[DOT_PRODUCT_BATCH*RSLength];
+    for(unsigned i0=0;i0<Points;i0+=DOT_PRODUCT_BATCH)
     {
-        GFValue* pDest=pGamma+i*UnitSize;
-        //\Lambda(0)=1, so we can just copy
-        memcpy(pDest,pSyndromes+i*UnitSize,sizeof(GFValue)*UnitSize);
-        //\Gamma_i=\sum_{j=0}^i S_{i-j}\Lambda_j
-        for(unsigned j=1;j<=i;j++)
+        unsigned r=min(Points-i0,(unsigned)DOT_PRODUCT_BATCH);
+        for(unsigned i=0;i<r;i++)
         {
-            if (pLambda[j])
-                MultiplyAdd(LogTable[pLambda[j]],pSyndromes+(i-j)*UnitSize,pDest,UnitSize);
+            int L=pScale[i0+i];
+            for(unsigned j=0;j<=Degree;j++)
+            {
+                Coefficients[i*(Degree+1)+j]=L;
+                L+=pX[i0+i];
+                if (L>=FieldSize_1) L-=FieldSize_1;
+            };
         };
+        DotProduct(ppSources,Degree+1,Coefficients,ppValues+i0,r,UnitSize);
     };
 };
 
-/** evaluate a block of polynomials at a given point 
-The degree must be >=0
+
+/**
+Any k symbols of the codeword determine the remaining ones. These are recovered as erasures
+via Forney algorithm, which is linear in the known symbols. The coefficients are obtained by
+decoding all the unit vectors at once: byte j of the unit of source j is 1, and all the other bytes are 0
 */
-void Evaluate(const GFValue* pPolynomials,///polynomials stored blockwise
-              unsigned Degree,///the degree of the polynomials
-              int x,///the polynomials will be evaluated here
-              GFValue* pValue, ///output will be placed here
-              unsigned UnitSize ///the number of polynomials to be evaluated (i.e. block size)
-              )
+void CRSProcessor::GetRecoveryCoefficients(const unsigned* pSources,///k symbol indices
+                                           const unsigned* pTargets,///symbol indices to be expressed
+                                           unsigned NumOfTargets,///the number of targets
+                                           int* pCoefficients///NumOfTargets x k matrix. Negative values stand for zero
+                                          )
 {
-    memcpy(pValue,pPolynomials,sizeof(GFValue)*UnitSize);
-    int L=x;
-    for(unsigned i=1;i<=Degree;i++,L+=x)
+    if (!NumOfTargets)
+        return;
+    //the symbols other than the sources are treated as erased
+    bool IsSource[RSLength];
+    memset(IsSource,0,sizeof(IsSource));
+    for(unsigned j=0;j<m_Dimension;j++)
+        IsSource[pSources[j]]=true;
+    //Lambda(x)=\prod_{i}(1-xX_i)
+    GFValue pLambda[RSLength+1];
+    memset(pLambda,0,sizeof(pLambda));
+    pLambda[0]=1;
+    unsigned t=0;
+    for(unsigned i=0;i<m_Length;i++)
     {
-        if (L>=FieldSize_1) L-=FieldSize_1;
-        MultiplyAdd(L,pPolynomials+i*UnitSize,pValue,UnitSize);
+        if (IsSource[i])
+            continue;
+        int Locator=GetLocator(i);
+		//multiply by (1-xX_i)
+        t++;
+        for(unsigned j=t;j>0;j--)
+        {
+            if (pLambda[j-1])
+            {
+                int L=LogTable[pLambda[j-1]]+Locator;
+                if (L>=FieldSize_1)
+                    L-=FieldSize_1;
+                pLambda[j]^=GF[1+L];
+            };
+        };
     };
-}
 
+    unsigned UnitSize=(m_Dimension+ARITHMETIC_ALIGNMENT-1)/ARITHMETIC_ALIGNMENT*ARITHMETIC_ALIGNMENT;
+    GFValue* pUnitVectors=AlignedMalloc(m_Dimension*UnitSize);
+    GFValue* pSyndrome=AlignedMalloc(t*UnitSize);
+    GFValue* pErasureEvaluator=AlignedMalloc(t*UnitSize);
+    GFValue* pValues=AlignedMalloc(NumOfTargets*UnitSize);
+    memset(pUnitVectors,0,m_Dimension*UnitSize);
+    const GFValue* ppData[RSLength];
+    memset(ppData,0,sizeof(ppData));
+    for(unsigned j=0;j<m_Dimension;j++)
+    {
+        pUnitVectors[j*UnitSize+j]=1;
+        ppData[GetLocator(pSources[j])]=pUnitVectors+j*UnitSize;
+    };
+    ComputeSyndrome(ppData,pSyndrome,0,t,UnitSize);
+    GetErasureEvaluator(pSyndrome,pLambda,pErasureEvaluator,t,UnitSize);
+    int pX[RSLength];
+    int pScale[RSLength];
+    GFValue* ppValues[RSLength];
+    for(unsigned i=0;i<NumOfTargets;i++)
+    {
+        int Locator=GetLocator(pTargets[i]);
+        pX[i]=(Locator)?FieldSize_1-Locator:0;
+        pScale[i]=GetForneyMultiple(t,pLambda,0,Locator);
+        ppValues[i]=pValues+i*UnitSize;
+    };
+    //X_i^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
+    EvaluateScaled(pErasureEvaluator,t-1,NumOfTargets,pX,pScale,ppValues,UnitSize);
+
+    for(unsigned i=0;i<NumOfTargets;i++)
+        for(unsigned j=0;j<m_Dimension;j++)
+        {
+            GFValue C=ppValues[i][j];
+            pCoefficients[i*m_Dimension+j]=(C)?LogTable[C]:-1;
+        };
+    AlignedFree(pValues);
+    AlignedFree(pErasureEvaluator);
+    AlignedFree(pSyndrome);
+    AlignedFree(pUnitVectors);
+};
 
 /**
-Fetch the non-erased symbols as is. If there are erased symbols,
-compute the syndrome S(x)=\sum_{i=0}^{t-1} S_i,
-where t is the number of erasures, S_i=\sum_{j=0}^{n-1} y_j X_j^i, X_j is the locator of the j-th symbol, y_j is assumed
-to be zero if it is erased,
-construct the erasure evaluator polynomial \Gamma(x)=S(x)\Lambda(x)\bmod x^{t},
-and recover the erasures via Forney algorithm
+Fetch the non-erased symbols as is. If some of the requested symbols are erased,
+fetch the k recovery sources selected by IsCorrectable, and compute the requested
+erased symbols in a single pass over them
 */
 bool CRSProcessor::DecodeDataSymbols(unsigned long long StripeID,///the stripe to be processed
                                   unsigned ErasureSetID,///identifies the load balancing offset
@@ -373,195 +442,101 @@ bool CRSProcessor::DecodeDataSymbols(unsigned long long StripeID,///the stripe t
                                  )
 {
 	bool NeedsDecoding=false;
-	//pointers to fetched data
-    const GFValue** ppData=m_ppSymbols+RSLength*ThreadID;
 	for(unsigned i=0;i<Symbols2Decode;i++)
 	{
-		unsigned S=SymbolID+i;
-		if (IsErased(ErasureSetID,S))
-		{
+		if (IsErased(ErasureSetID,SymbolID+i))
 			NeedsDecoding=true;
-			ppData[m_pInfSymbols[S]]=0;
-		}else
+		else
 		{
 			//fetch it 
 			if (!ReadStripeUnit(StripeID,ErasureSetID,SymbolID+i,0,1,pDest+i*m_StripeUnitSize))
 				return false;
-			//save the pointer if we need it for decoding
-			ppData[m_pInfSymbols[S]]=pDest+i*m_StripeUnitSize;
 		};
 	};
 	if (NeedsDecoding)
 	{
 		GFValue* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
-		//fetch all surviving information symbols
-		for(unsigned i=0;i<SymbolID;i++)
-		{
-			if (IsErased(ErasureSetID,i))
-			{
-				ppData[m_pInfSymbols[i]]=0;
-			}
-			else
-			{
-				//fetch it 
-				ppData[m_pInfSymbols[i]]=pFetchBuffer+i*m_StripeUnitSize;
-				if (!ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pFetchBuffer+i*m_StripeUnitSize))
-					return false;
-			};
-		};
-        for(unsigned i=SymbolID+Symbols2Decode;i<m_Dimension;i++)
+        //pointers to the recovery sources
+        const GFValue** ppData=m_ppSources+m_Length*ThreadID;
+        const unsigned* pSources=m_pRecoverySources+ErasureSetID*m_Dimension;
+        for(unsigned j=0;j<m_Dimension;j++)
         {
-			if (IsErased(ErasureSetID,i))
-			{
-				ppData[m_pInfSymbols[i]]=0;
-			}
-			else
-			{
-				//fetch it 
-				ppData[m_pInfSymbols[i]]=pFetchBuffer+i*m_StripeUnitSize;
-				if (!ReadStripeUnit(StripeID,ErasureSetID,i,0,1,pFetchBuffer+i*m_StripeUnitSize))
-					return false;
-			};
+            unsigned S=pSources[j];
+            if (S>=SymbolID&&S<SymbolID+Symbols2Decode)
+                //it has been already fetched
+                ppData[j]=pDest+(S-SymbolID)*m_StripeUnitSize;
+            else
+            {
+                ppData[j]=pFetchBuffer+S*m_StripeUnitSize;
+                if (!ReadStripeUnit(StripeID,ErasureSetID,S,0,1,pFetchBuffer+S*m_StripeUnitSize))
+                    return false;
+            };
         };
-        //fetch all surviving check symbols
-        for(unsigned i=0;i<m_Redundancy;i++)
+        //the requested erased symbols are consecutive recovery targets
+        const unsigned* pTargets=m_pRecoveryTargets+ErasureSetID*m_Redundancy;
+        unsigned NumOfTargets=m_pNumOfRecoveryTargets[ErasureSetID];
+        unsigned First=0;
+        while (First<NumOfTargets&&pTargets[First]<SymbolID)
+            First++;
+        GFValue* ppValues[RSLength];
+        unsigned Points=0;
+        while (First+Points<NumOfTargets&&pTargets[First+Points]<SymbolID+Symbols2Decode)
         {
-			if (IsErased(ErasureSetID,m_Dimension+i))
-			{
-                ppData[m_pCheckSymbols[i]]=0;
-			}
-			else
-			{
-				//fetch it 
-                ppData[m_pCheckSymbols[i]]=pFetchBuffer+(m_Dimension+i)*m_StripeUnitSize;
-				if (!ReadStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer+(m_Dimension+i)*m_StripeUnitSize))
-					return false;
-			};
-        };
-        GFValue* pSyndrome=m_pSyndromes+ThreadID*m_Redundancy*m_StripeUnitSize;
-        GFValue* pErasureEvaluator=m_pErasureEvaluator+ThreadID*m_Redundancy*m_StripeUnitSize;
-#ifndef STUDENTBUILD
-		if (m_CyclotomicProcessing)
-		{
-		//   ComputeSyndrome(ppData,pSyndrome,m_FirstRoot,m_FirstRoot+m_Redundancy,m_StripeUnitSize);
-			ComputeSyndromeCyclotomic(ppData,pSyndrome,m_Redundancy,m_pCyclotomicTemp+ThreadID*CYCLOTOMIC_TEMP_SIZE*m_StripeUnitSize,pErasureEvaluator,m_StripeUnitSize);
-		}else 
-#endif
-            ComputeSyndrome(ppData,pSyndrome,0,m_Redundancy,m_StripeUnitSize);
-
-        GetErasureEvaluator(pSyndrome,m_pErasureLocators+ErasureSetID*(m_Redundancy+1),pErasureEvaluator,GetNumOfErasures(ErasureSetID),m_StripeUnitSize);
-        //recover the erasures
-        const int* pErasureLocatorsPrime=m_pErasureLocatorsPrime+ErasureSetID*m_Redundancy;
-        for(unsigned i=0;i<GetNumOfErasures(ErasureSetID);i++)
-	    {
-            unsigned S=GetErasedPosition(ErasureSetID,i);
-            if (S<SymbolID) continue;
-            if (S>=SymbolID+Symbols2Decode)continue;
-            int X=(m_pInfSymbols[S])?FieldSize_1-m_pInfSymbols[S]:0;
-            GFValue* pCurDest=pDest+(S-SymbolID)*m_StripeUnitSize;
-            //\Gamma(1/X_i)
-            Evaluate(pErasureEvaluator,GetNumOfErasures(ErasureSetID)-1,X,pCurDest,m_StripeUnitSize);
-            //\alpha^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
-            Multiply(pErasureLocatorsPrime[i],pCurDest,pCurDest,m_StripeUnitSize);
+            ppValues[Points]=pDest+(pTargets[First+Points]-SymbolID)*m_StripeUnitSize;
+            Points++;
         };
+        DotProduct(ppData,m_Dimension,m_pRecoveryCoefficients+(ErasureSetID*m_Redundancy+First)*m_Dimension,ppValues,Points,m_StripeUnitSize);
 	};
     return true;
 };
-    ///encode and write the whole stripe
-    ///@return true on success
+/**The surviving requested symbols are read directly. If some of them are erased, DecodeDataSymbols
+also reads the m_Dimension recovery sources selected by IsCorrectable. The symbols consist of
+a single stripe unit, so the symbols are counted
+*/
+unsigned CRSProcessor::GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                   unsigned StripeUnitID,///the first stripe unit to be read
+                                   unsigned NumOfUnits,///the number of units to be read
+                                   size_t ThreadID ///the ID of the calling thread
+                                  )
+{
+    return GetRecoveryReadCost(ErasureSetID,StripeUnitID,NumOfUnits,m_pRecoverySources+ErasureSetID*m_Dimension,m_Dimension);
+};
+
+/**encode and write the whole stripe.
+The check symbols are computed in a single pass over the data using the systematic encoding matrix
+@return true on success
+*/
 bool CRSProcessor::EncodeStripe(unsigned long long StripeID,///the stripe to be encoded
                               unsigned ErasureSetID,///identifies the load balancing offset
                               const unsigned char* pData,///the data to be envoced
                               size_t ThreadID ///the ID of the calling thread
                  )
 {
-    //initialize the information symbol positions and compute check ones via erasure decoding
-	const GFValue** ppData=m_ppSymbols+RSLength*ThreadID;
+	const GFValue** ppData=m_ppSources+m_Length*ThreadID;
     for(unsigned i=0;i<m_Dimension;i++)
     {
-        ppData[m_pInfSymbols[i]]=pData+i*m_StripeUnitSize;
+        ppData[i]=pData+i*m_StripeUnitSize;
         //send the data to disk
         WriteStripeUnit(StripeID,ErasureSetID,i,0,1,pData+i*m_StripeUnitSize);
     };
-    for(unsigned i=0;i<m_Redundancy;i++)
-        ppData[m_pCheckSymbols[i]]=0;
-
+    //use pSyndrome as a temporary storage
     GFValue* pSyndrome=m_pSyndromes+ThreadID*m_Redundancy*m_StripeUnitSize;
-    GFValue* pErasureEvaluator=m_pErasureEvaluator+ThreadID*m_Redundancy*m_StripeUnitSize;
-#ifndef STUDENTBUILD
-    if (m_CyclotomicProcessing)
-    {
-//        ComputeSyndrome(ppData,pSyndrome,m_FirstRoot,m_FirstRoot+m_Redundancy,m_StripeUnitSize);
-		ComputeSyndromeCyclotomic(ppData,pSyndrome,m_Redundancy,m_pCyclotomicTemp+ThreadID*CYCLOTOMIC_TEMP_SIZE*m_StripeUnitSize,pErasureEvaluator,m_StripeUnitSize);
-    }else
-#endif
-        ComputeSyndrome(ppData,pSyndrome,0,m_Redundancy,m_StripeUnitSize);
-
-
-
-    GetErasureEvaluator(pSyndrome,m_pCheckLocator,pErasureEvaluator,m_Redundancy,m_StripeUnitSize);
-#ifndef STUDENTBUILD
-   if (m_OptimizedCheckLocators)
-    {
-        //use pSyndrome as a temporary storage
-        //\Gamma(1/X_i)
-        CheckLocators[m_Redundancy-1].Evaluator(pErasureEvaluator,pSyndrome,m_StripeUnitSize);
-        //recover the erased check symbols
-        for(unsigned i=0;i<m_Redundancy;i++)
-        {
-            int X=(m_pCheckSymbols[i])?FieldSize_1-m_pCheckSymbols[i]:0;
-            //Evaluate(pErasureEvaluator,m_Redundancy-1,X,pSyndrome+i*m_StripeUnitSize,m_StripeUnitSize);
-
-            //X_i^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
-            Multiply(m_pCheckLocatorsPrime[i],pSyndrome+i*m_StripeUnitSize,pSyndrome+i*m_StripeUnitSize,m_StripeUnitSize);
-            //send check symbols to disk
-            WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pSyndrome+i*m_StripeUnitSize);
-        };
-
-    }else
-#endif
-   {
-        //recover the erased check symbols
-        for(unsigned i=0;i<m_Redundancy;i++)
-        {
-            int X=(m_pCheckSymbols[i])?FieldSize_1-m_pCheckSymbols[i]:0;
-            //use pSyndrome as a temporary storage
-            //\Gamma(1/X_i)
-            Evaluate(pErasureEvaluator,m_Redundancy-1,X,pSyndrome,m_StripeUnitSize);
-            //X_i^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
-            Multiply(m_pCheckLocatorsPrime[i],pSyndrome,pSyndrome,m_StripeUnitSize);
-            //send check symbols to disk
-            WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pSyndrome);
-        };
-    };
+    GFValue* ppValues[RSLength];
+    for(unsigned i=0;i<m_Redundancy;i++)
+        ppValues[i]=pSyndrome+i*m_StripeUnitSize;
+    DotProduct(ppData,m_Dimension,m_pParityCoefficients,ppValues,m_Redundancy,m_StripeUnitSize);
+    //send check symbols to disk
+    for(unsigned i=0;i<m_Redundancy;i++)
+        WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,ppValues[i]);
 
     return true;
 
 };
 
-/** If the range of symbols to be updated does not include any erasures, use the standard decision rule.
-Otherwise, do full fetch-combine-encode cycle
-*/
-bool CRSProcessor::GetEncodingStrategy(unsigned ErasureSetID,///identifies the load balancing offset
-                                     unsigned StripeUnitID,///the first stripe unit to be updated
-                                    unsigned Subsymbols2Encode ///the number of subsymbols to be encoded
-                 )
-{
-	for(unsigned i=0;i<GetNumOfErasures(ErasureSetID);i++)
-    {
-        if (GetErasedPosition(ErasureSetID,i)<(int)StripeUnitID) 
-            continue;//it does not belong into the update set
-        if (GetErasedPosition(ErasureSetID,i)>=int(StripeUnitID+Subsymbols2Encode)) 
-            continue;//it does not belong into the update set
-
-        //erased symbol has to be updated, do full encoding
-        return true;
-    };
-	return CRAIDProcessor::GetEncodingStrategy(ErasureSetID,StripeUnitID,Subsymbols2Encode);
-
-};
 /**update some information symbols and the corresponding check symbols
-This will fetch old values of the symbols to be updated, compute the corresponding syndrome and 
+This will fetch the old values of the symbols to be updated and of the check symbols, and compute the new
+check symbols in a single pass over the data differences and the old check symbols:
+c_i'=c_i+\sum_j (y_j'-y_j)\alpha^{g_{ij}}, where g_{ij} are the systematic encoding coefficients
    @return true on success
 
    */
@@ -573,75 +548,51 @@ bool CRSProcessor::UpdateInformationSymbols(unsigned long long StripeID,///the s
     size_t ThreadID ///the ID of the calling thread
     )
 {
-    //assume here that there are no erasures
+    //assume here that there are no erased information symbols
     GFValue* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
-    const GFValue** ppData=m_ppSymbols+RSLength*ThreadID;
-    memset(ppData,0,RSLength*sizeof(ppData[0]));
+    const GFValue** ppData=m_ppSources+m_Length*ThreadID;
     bool Result=true;
+    //fetch the old data and the check symbols to be updated
     for(unsigned i=0;i<Units2Update;i++)
     {
-        //find the difference between new and old values
-        GFValue* pCurSymbol=pFetchBuffer+i*m_StripeUnitSize;
-        Result&=ReadStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pCurSymbol);
-        XOR(pCurSymbol,pData+i*m_StripeUnitSize,m_StripeUnitSize);
-        ppData[m_pInfSymbols[StripeUnitID+i]]=pCurSymbol;
-        //save the new value
-        Result&=WriteStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pData+i*m_StripeUnitSize);
+        ppData[i]=pFetchBuffer+i*m_StripeUnitSize;
+        Result&=ReadStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pFetchBuffer+i*m_StripeUnitSize);
     };
-    GFValue* pSyndrome=m_pSyndromes+ThreadID*m_Redundancy*m_StripeUnitSize;
-    GFValue* pErasureEvaluator=m_pErasureEvaluator+ThreadID*m_Redundancy*m_StripeUnitSize;
-#ifndef STUDENTBUILD
-    if (m_CyclotomicProcessing)
+    unsigned Checks[RSLength];
+    unsigned NumOfChecks=0;
+    for(unsigned i=0;i<m_Redundancy;i++)
     {
-     //   ComputeSyndrome(ppData,pSyndrome,m_FirstRoot,m_FirstRoot+m_Redundancy,m_StripeUnitSize);
-		ComputeSyndromeCyclotomic(ppData,pSyndrome,m_Redundancy,m_pCyclotomicTemp+ThreadID*CYCLOTOMIC_TEMP_SIZE*m_StripeUnitSize,pErasureEvaluator,m_StripeUnitSize);
-
-    }
-    else
-#endif
-        ComputeSyndrome(ppData,pSyndrome,0,m_Redundancy,m_StripeUnitSize);
-    
-    GetErasureEvaluator(pSyndrome,m_pCheckLocator,pErasureEvaluator,m_Redundancy,m_StripeUnitSize);
-#ifndef STUDENTBUILD
-    if (m_OptimizedCheckLocators)
+        if (IsErased(ErasureSetID,m_Dimension+i))
+            //no need to update this symbol
+            continue;
+        GFValue* pCheck=pFetchBuffer+(Units2Update+NumOfChecks)*m_StripeUnitSize;
+        ppData[Units2Update+NumOfChecks]=pCheck;
+        Result&=ReadStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pCheck);
+        Checks[NumOfChecks++]=i;
+    };
+    //find the differences between new and old values
+    for(unsigned i=0;i<Units2Update;i++)
+        XOR(pFetchBuffer+i*m_StripeUnitSize,pData+i*m_StripeUnitSize,m_StripeUnitSize);
+    //new check symbol j is the old one plus the encoded differences
+    unsigned k=Units2Update+NumOfChecks;
+    int* pCoefficients=m_pUpdateCoefficients+ThreadID*m_Redundancy*m_Length;
+    GFValue* ppValues[RSLength];
+    for(unsigned j=0;j<NumOfChecks;j++)
     {
+        const int* pRow=m_pParityCoefficients+Checks[j]*m_Dimension+StripeUnitID;
+        for(unsigned i=0;i<Units2Update;i++)
+            pCoefficients[j*k+i]=pRow[i];
+        for(unsigned i=0;i<NumOfChecks;i++)
+            pCoefficients[j*k+Units2Update+i]=(i==j)?0:-1;
         //use pSyndrome as a temporary storage
-        //\Gamma(1/X_i)
-        CheckLocators[m_Redundancy-1].Evaluator(pErasureEvaluator,pSyndrome,m_StripeUnitSize);
-        //recover the erased check symbols
-        for(unsigned i=0;i<m_Redundancy;i++)
-        {
-            int X=(m_pCheckSymbols[i])?FieldSize_1-m_pCheckSymbols[i]:0;
-            //fetch old value 
-            Result&=ReadStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer);
-            //X_i^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
-            MultiplyAdd(m_pCheckLocatorsPrime[i],pSyndrome+i*m_StripeUnitSize,pFetchBuffer,m_StripeUnitSize);
-            //send check symbols to disk
-            WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer);
-        };
-
-    }else
-#endif
-    {
-
-        //recover the erased check symbols
-        for(unsigned i=0;i<m_Redundancy;i++)
-        {
-            if (IsErased(ErasureSetID,m_Dimension+i)) 
-                //no need to update this symbol
-                continue;
-            int X=(m_pCheckSymbols[i])?FieldSize_1-m_pCheckSymbols[i]:0;
-            //use pSyndrome as a temporary storage
-            //\Gamma(1/X_i)
-            Evaluate(pErasureEvaluator,m_Redundancy-1,X,pSyndrome,m_StripeUnitSize);
-            //fetch old value 
-            Result&=ReadStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer);
-            //add to it X_i^{1-b}\Gamma(1/X_i)/\Lambda'(1/X_i)
-            MultiplyAdd(m_pCheckLocatorsPrime[i],pSyndrome,pFetchBuffer,m_StripeUnitSize);
-            //write it back
-            Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+i,0,1,pFetchBuffer);
-        };
+        ppValues[j]=m_pSyndromes+(ThreadID*m_Redundancy+j)*m_StripeUnitSize;
     };
+    DotProduct(ppData,k,pCoefficients,ppValues,NumOfChecks,m_StripeUnitSize);
+    //save the new values
+    for(unsigned i=0;i<Units2Update;i++)
+        Result&=WriteStripeUnit(StripeID,ErasureSetID,StripeUnitID+i,0,1,pData+i*m_StripeUnitSize);
+    for(unsigned j=0;j<NumOfChecks;j++)
+        Result&=WriteStripeUnit(StripeID,ErasureSetID,m_Dimension+Checks[j],0,1,ppValues[j]);
 
     return true;
 };
@@ -657,6 +608,8 @@ bool CRSProcessor::CheckCodeword(unsigned long long StripeID,///the stripe to be
         return true;
     GFValue* pFetchBuffer=m_pSymbols+ThreadID*m_Length*m_StripeUnitSize;
 	const GFValue** ppData=m_ppSymbols+RSLength*ThreadID;
+    //the positions not covered by the codeword must be zero
+    memset(ppData,0,RSLength*sizeof(GFValue*));
     //fetch information symbols
     for(unsigned i=0;i<m_Dimension;i++)
     {
@@ -673,11 +626,7 @@ bool CRSProcessor::CheckCodeword(unsigned long long StripeID,///the stripe to be
     };
     GFValue* pSyndrome=m_pSyndromes+ThreadID*m_Redundancy*m_StripeUnitSize;
     ComputeSyndrome(ppData,pSyndrome,0,m_Redundancy,m_StripeUnitSize);
-    GFValue X=0;
-    for (unsigned i=0;i<m_Redundancy*m_StripeUnitSize;i++)
-        X|=pSyndrome[i];
-
-    return X==0;
+    return IsZero(pSyndrome,m_Redundancy*m_StripeUnitSize);
 }
 
 
@@ -1,10 +1,13 @@
 #include "RTP.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <iostream>
 #include <ranges>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include "workerpool.h"
 
 #define TODO(msg)                                                                   \
   throw std::runtime_error(std::string(__FILE__) + ":" + std::to_string(__LINE__) + \
@@ -41,24 +44,101 @@ template <typename T>
 auto iota(T to) {
   return iota(static_cast<T>(0), to);
 }
+
+/// Lanes are split at cache line boundaries, and are large enough to amortize the scheduling
+constexpr std::size_t kCacheLineSize = 64;
+constexpr std::size_t kMinLaneSize = 32 * 1024;
+
+/// the largest number of lanes forEachLane may use
+std::size_t maxLanes() {
+  auto* const pool = GetWorkerPool();
+  return pool ? pool->GetNumOfWorkers() + 1 : 1;
+}
+
+/// Call fn(lane, begin, end) for disjoint byte ranges covering [0, size), lane < maxLanes().
+/// Bytes at different offsets of stripe units are processed independently by XOR, so
+/// the ranges are processed in parallel on the shared worker pool if size is large enough
+template <typename Fn>
+void forEachLane(std::size_t size, Fn&& fn) {
+  auto lanes = std::min(maxLanes(), size / kMinLaneSize);
+  if (lanes <= 1) {
+    fn(0u, std::size_t{0}, size);
+    return;
+  }
+  auto const laneSize = (size / lanes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+  lanes = (size + laneSize - 1) / laneSize;
+  GetWorkerPool()->Run(lanes, [&](unsigned lane) {
+    fn(lane, lane * laneSize, std::min(size, (lane + 1) * laneSize));
+  });
+}
 }  // namespace
 
+CRTPProcessor::TripleDecoding CRTPProcessor::s_TripleDecoding = TripleDecoding::kClosedForm;
+
+void CRTPProcessor::SetTripleDecoding(TripleDecoding Mode) noexcept {
+  s_TripleDecoding = Mode;
+}
+
 /// initialize coding-related parameters
 CRTPProcessor::CRTPProcessor(RTPParams* P  /// the configuration file
                              )
-    : CRAIDProcessor(P->CodeDimension + 3, P->CodeDimension, P, sizeof(*P)),
-      p(P->CodeDimension + 1) {
-  if (!isPrime(p)) {
-    throw std::invalid_argument("Dimension+1 should be prime");
+    : CRAIDProcessor(P->CodeDimension + 3, GetPrime(P->CodeDimension) - 1, P, sizeof(*P)),
+      p(GetPrime(P->CodeDimension)),
+      m_ZeroSymbol(SymbolSize(), true),
+      m_TripleDecoding(s_TripleDecoding) {
+  m_DiagOffsets.resize(p * m_StripeUnitsPerSymbol);
+  m_AntiDiagOffsets.resize(p * m_StripeUnitsPerSymbol);
+  m_DiagNums.resize(p * m_StripeUnitsPerSymbol);
+  m_AntiDiagNums.resize(p * m_StripeUnitsPerSymbol);
+  for (unsigned const s : iota(p)) {
+    for (unsigned const j : iota(m_StripeUnitsPerSymbol)) {
+      auto const i = s * m_StripeUnitsPerSymbol + j;
+      m_DiagNums[i] = static_cast<unsigned>(DiagNum(false, s, j));
+      m_AntiDiagNums[i] = static_cast<unsigned>(DiagNum(true, s, j));
+      m_DiagOffsets[i] = m_DiagNums[i] * m_StripeUnitSize;
+      m_AntiDiagOffsets[i] = m_AntiDiagNums[i] * m_StripeUnitSize;
+    }
   }
 }
 
-bool CRTPProcessor::ReadSymbol(unsigned long long int StripeID,
-                               unsigned int ErasureSetID,
-                               unsigned int SymbolID,
-                               AlignedBuffer& out) {
-  assert(out.size() >= SymbolSize());
-  return ReadSymbol(StripeID, ErasureSetID, SymbolID, out.data());
+unsigned CRTPProcessor::GetPrime(unsigned Dimension) {
+  if (!Dimension) {
+    throw std::invalid_argument("Dimension should be positive");
+  }
+  auto result = Dimension + 1;
+  while (!isPrime(result)) {
+    ++result;
+  }
+  return result;
+}
+
+bool CRTPProcessor::Attach(CDiskArray* pArray, unsigned ConcurrentThreads) {
+  auto const symbolSize = SymbolSize();
+  // The chain buffers have room for the unstored diagonal and the extra row
+  auto const chainSize = symbolSize + m_StripeUnitSize;
+  m_Workspaces.clear();
+  m_Workspaces.resize(ConcurrentThreads);
+  for (auto& ws : m_Workspaces) {
+    ws.symbols.reserve(p);
+    for ([[maybe_unused]] unsigned const s : iota(p)) {
+      ws.symbols.emplace_back(symbolSize);
+    }
+    ws.diag = AlignedBuffer(chainSize);
+    ws.adiag = AlignedBuffer(chainSize);
+    ws.row = AlignedBuffer(chainSize);
+    ws.rhs = AlignedBuffer(chainSize);
+    ws.erasedData = AlignedBuffer(3 * symbolSize);
+    if (m_TripleDecoding == TripleDecoding::kSelfCheck) {
+      ws.check = AlignedBuffer(symbolSize);
+    }
+    ws.symbolData.resize(p);
+    ws.sources.resize(p * maxLanes());
+    ws.loaded.resize(3 * m_StripeUnitsPerSymbol);
+    ws.involved.resize((p + 2) * m_StripeUnitsPerSymbol);
+    ws.pending.reserve(p * m_StripeUnitsPerSymbol);
+    ws.needed.reserve(p * m_StripeUnitsPerSymbol);
+  }
+  return CRAIDProcessor::Attach(pArray, ConcurrentThreads);
 }
 
 bool CRTPProcessor::ReadSymbol(unsigned long long int StripeID,
@@ -74,17 +154,19 @@ bool CRTPProcessor::ReadSubsymbols(unsigned long long int StripeID,
                                    unsigned char* out,
                                    unsigned int start,
                                    unsigned int count) {
-  assert(!IsErased(ErasureSetID, SymbolID));
-  return ReadStripeUnit(StripeID, ErasureSetID, SymbolID, start, count, out);
+  assert(!IsSymbolErased(ErasureSetID, SymbolID));
+  if (IsVirtual(SymbolID)) {
+    memset(out, 0, count * m_StripeUnitSize);
+    return true;
+  }
+  return ReadStripeUnit(StripeID, ErasureSetID, SymbolDisk(SymbolID), start, count, out);
 }
 
 bool CRTPProcessor::WriteSymbol(unsigned long long int StripeID,
                                 unsigned int ErasureSetID,
                                 unsigned int SymbolID,
-                                AlignedBuffer const& symbol) {
-  assert(symbol.size() == SymbolSize());
-  return WriteSubsymbols(StripeID, ErasureSetID, SymbolID, symbol.data(), 0,
-                         m_StripeUnitsPerSymbol);
+                                unsigned char const* symbol) {
+  return WriteSubsymbols(StripeID, ErasureSetID, SymbolID, symbol, 0, m_StripeUnitsPerSymbol);
 }
 
 bool CRTPProcessor::WriteSubsymbols(unsigned long long int StripeID,
@@ -93,7 +175,7 @@ bool CRTPProcessor::WriteSubsymbols(unsigned long long int StripeID,
                                     unsigned char const* data,
                                     unsigned start,
                                     unsigned count) {
-  return WriteStripeUnit(StripeID, ErasureSetID, SymbolID, start, count, data);
+  return WriteStripeUnit(StripeID, ErasureSetID, SymbolDisk(SymbolID), start, count, data);
 }
 
 void operator^=(std::vector<bool>& lhs, std::vector<bool> const& rhs) {
@@ -145,140 +227,135 @@ bool CRTPProcessor::DecodeDataSymbols(
     return ok;
   }
 
-  auto const NumErasedRaid4Symbols = GetNumErasedRaid4Symbols(ErasureSetID);
+  // The requested symbols are read and restored directly in pDest
+  assert(ThreadID < m_Workspaces.size());
+  return RestoreSymbols(StripeID, ErasureSetID, FirstSymbolID, LastSymbolID, pDest,
+                        m_Workspaces[ThreadID]);
+}
 
-  auto symbols = std::vector<AlignedBuffer>();
-  symbols.reserve(p);
+bool CRTPProcessor::RestoreSymbols(unsigned long long StripeID,
+                                   unsigned ErasureSetID,
+                                   unsigned FirstSymbolID,
+                                   unsigned LastSymbolID,
+                                   unsigned char* pDest,
+                                   Workspace& ws) {
+  auto const symbolSize = SymbolSize();
+  auto [X, Y, Z] = GetErasedSymbols(ErasureSetID);
+  auto const wasRequested = [FirstSymbolID, LastSymbolID](int s) -> bool {
+    if (s < 0) {
+      return false;
+    } else {
+      std::size_t symbolId = s;
+      return FirstSymbolID <= symbolId && symbolId < LastSymbolID;
+    }
+  };
+  bool ok = true;
+
+  auto const NumErasedRaid4Symbols = GetNumErasedRaid4Symbols(ErasureSetID);
 
-  auto diag = AlignedBuffer();
-  bool const isAnti = IsErased(ErasureSetID, p);
+  // Place the requested symbols in pDest, and the other ones in the workspace
+  auto& symbols = ws.symbolData;
+  for (unsigned const s : iota(p)) {
+    if (IsVirtual(s)) {
+      symbols[s] = m_ZeroSymbol.data();
+    } else {
+      symbols[s] = (pDest && wasRequested(s)) ? pDest + (s - FirstSymbolID) * symbolSize
+                                              : ws.symbols[s].data();
+    }
+  }
+  auto* const diag = ws.diag.data();
+  bool const isAnti = IsSymbolErased(ErasureSetID, p);
+  auto* const adiag = ws.adiag.data();
+  auto* const row = ws.row.data();
   if (NumErasedRaid4Symbols > 1) {
-    diag = AlignedBuffer(symbolSize + m_StripeUnitSize);
     auto const d = isAnti ? p + 1 : p;
-    assert(!IsErased(ErasureSetID, d));
+    assert(!IsSymbolErased(ErasureSetID, d));
     ok &= ReadSymbol(StripeID, ErasureSetID, d, diag);
-    auto const missing = &diag[symbolSize];
-    memcpy(missing, diag.data(), m_StripeUnitSize);
-    for (unsigned const i : iota(1u, m_StripeUnitsPerSymbol)) {
-      XOR(missing, diag.data() + i * m_StripeUnitSize, m_StripeUnitSize);
-    }
+    RestoreMissingDiag(diag, ws.sources.data());
+  }
+  if (NumErasedRaid4Symbols == 3) {
+    // Read the p-1 stored anti-diagonal subsymbols
+    assert(!isAnti);
+    ok &= ReadSymbol(StripeID, ErasureSetID, p + 1, adiag);
+    RestoreMissingDiag(adiag, ws.sources.data());
+    memset(row, 0, symbolSize + m_StripeUnitSize);
   }
 
+  // The erased symbols are restored below without being zeroed first
   for (std::size_t const s : iota(p)) {
-    if (IsErased(ErasureSetID, s)) {
-      symbols.emplace_back(symbolSize, true);
-    } else {
-      auto symbol = AlignedBuffer(symbolSize, false);
+    auto* const symbol = symbols[s];
+    if (!IsSymbolErased(ErasureSetID, s) && !IsVirtual(s)) {
       ok &= ReadSymbol(StripeID, ErasureSetID, s, symbol);
-      if (diag.data() != nullptr) {
+      if (NumErasedRaid4Symbols == 3) {
+        AddToChains(row, diag, adiag, s, symbol);
+      } else if (NumErasedRaid4Symbols > 1) {
         AddToDiag(diag, isAnti, s, symbol);
       }
-      symbols.push_back(std::move(symbol));
     }
   }
-  assert(symbols.size() == p);
 
   switch (NumErasedRaid4Symbols) {
     case 3: {  // RTP
-      assert(!IsErased(ErasureSetID, p));
-      assert(!IsErased(ErasureSetID, p + 1));
-      // diag is the non-anti diagonal
+      assert(!IsSymbolErased(ErasureSetID, p));
+      assert(!IsSymbolErased(ErasureSetID, p + 1));
+      // diag is the non-anti diagonal, and the RAID4 symbols have been added
+      // to diag, anti-diag and row
       assert(!isAnti);
 
-      auto adiag = AlignedBuffer(symbolSize + m_StripeUnitSize, false);
-      {
-        // Read the p-1 stored subsymbols
-        ok &= ReadSymbol(StripeID, ErasureSetID, p + 1, adiag);
-
-        {  // Restore the missing subsymbol using XOR
-          auto const missing = &adiag[symbolSize];
-          memcpy(missing, adiag.data() + 0 * m_StripeUnitSize, m_StripeUnitSize);
-          for (unsigned const i : iota(1u, m_StripeUnitsPerSymbol)) {
-            XOR(missing, adiag.data() + i * m_StripeUnitSize, m_StripeUnitSize);
-          }
+      auto* const rhs = ws.rhs.data();
+      auto const* const plan =
+          (m_TripleDecoding != TripleDecoding::kClosedForm)
+              ? &m_TriplePlans.at(std::pair<unsigned, unsigned>(Y - X, Z - X))
+              : nullptr;
+      auto* const check =
+          (m_TripleDecoding == TripleDecoding::kSelfCheck) ? ws.check.data() : nullptr;
+      std::atomic<bool> mismatch = false;
+      forEachLane(m_StripeUnitSize, [&](unsigned lane, std::size_t begin, std::size_t end) {
+        auto const size = end - begin;
+        auto const unit = [this, begin](unsigned char* base, unsigned i) {
+          return base + i * m_StripeUnitSize + begin;
+        };
+        auto* const sources = ws.sources.data() + lane * p;
+        for (unsigned const k : iota(p)) {
+          auto const d = DiagNum(false, Z, k);
+          auto const ad = DiagNum(true, X, k);
+          auto const q = (k + Z - X) % p;
+          assert(DiagNum(false, Z, k) == DiagNum(false, X, q));
+          sources[0] = unit(row, k);
+          sources[1] = unit(diag, d);
+          sources[2] = unit(adiag, ad);
+          sources[3] = unit(row, q);
+          XORN(unit(rhs, k), sources, 4, size);
         }
-      }
 
-      auto row = AlignedBuffer(symbolSize + m_StripeUnitSize, true);
-
-      // Add the RAID4 symbols to anti-diag & row
-      for (std::size_t const s : iota(p)) {
-        [[maybe_unused]] auto const& symbol = symbols[s];
-        if (IsErased(ErasureSetID, s)) {
-          assert(symbol.isZero());
-        } else {
-          row ^= symbol;
-          AddToDiag(adiag, true, s, symbol);
+        if (!plan) {
+          // row is not needed anymore, and is used for the pair sums
+          RestoreMiddleSymbol(Y - X, Z - X, rhs, row, symbols[Y], sources, begin, size);
+          return;
         }
-      }
-
-      auto lhs = std::vector(p, std::vector(p - 1, false));
-      assert(X < Y && Y < Z);
-      for (unsigned const k : iota(p)) {
-        for (unsigned const c : {
-                 k,
-                 k + (Z - Y),
-                 k + (Y - X),
-                 k + (Z - X),
-             }) {
-          auto const i = c % p;
-          if (i != p - 1) {
-            lhs[k][i].flip();
+        // Solve the linear equations by replaying the precomputed schedule
+        for (unsigned const i : iota(p - 1)) {
+          auto n = 0u;
+          for (unsigned const j : iota(plan->start[i], plan->start[i + 1])) {
+            sources[n++] = unit(rhs, plan->rows[j]);
           }
+          XORN(unit(symbols[Y], i), sources, n, size);
         }
-      }
-
-      auto rhs = row.clone();
-      for (unsigned const k : iota(p)) {
-        auto const d = DiagNum(false, Z, k);
-        auto const ad = DiagNum(true, X, k);
-        auto const q = (k + Z - X) % p;
-        assert(DiagNum(false, Z, k) == DiagNum(false, X, q));
-        auto pos = &rhs[k * m_StripeUnitSize];
-        XOR(pos, &diag[d * m_StripeUnitSize], m_StripeUnitSize);
-        XOR(pos, &adiag[ad * m_StripeUnitSize], m_StripeUnitSize);
-        XOR(pos, &row[q * m_StripeUnitSize], m_StripeUnitSize);
-      }
-
-
-      // Linear equations
-      for (unsigned const r : iota(p - 1)) {
-        if (!lhs[r][r]) {
-          for (unsigned const other : iota(r + 1, p)) {
-            if (lhs[other][r]) {
-              assert(other != r);
-              std::swap(lhs[r], lhs[other]);
-              auto* a = &rhs[r * m_StripeUnitSize];
-              auto* b = &rhs[other * m_StripeUnitSize];
-              std::swap_ranges(a, a + m_StripeUnitSize, b);
-              break;
+        if (check) {
+          // The closed form overwrites a unit of rhs, so it goes after the plan
+          RestoreMiddleSymbol(Y - X, Z - X, rhs, row, check, sources, begin, size);
+          for (unsigned const i : iota(p - 1)) {
+            if (!Equal(unit(symbols[Y], i), unit(check, i), size)) {
+              mismatch = true;
             }
           }
         }
-
-        assert(lhs[r][r]);
-        for (unsigned const other : iota(p)) {
-          if (r != other && lhs[other][r]) {
-            lhs[other] ^= lhs[r];
-            XOR(&rhs[other * m_StripeUnitSize], &rhs[r * m_StripeUnitSize], m_StripeUnitSize);
-          }
-        }
-      }
-
-      for ([[maybe_unused]] unsigned const r : iota(p)) {
-        for ([[maybe_unused]] unsigned const c : iota(p - 1)) {
-          assert((r == c) == lhs[r][c]);
-        }
-      }
-
-      for ([[maybe_unused]] auto const b : lhs.back()) {
-        assert(!b);
+      });
+      if (mismatch) {
+        std::cerr << "RTP triple erasure decoders disagree on stripe " << StripeID
+                  << ", erased symbols " << X << ' ' << Y << ' ' << Z << std::endl;
+        ok = false;
       }
-      for ([[maybe_unused]] unsigned const i : iota(m_StripeUnitSize)) {
-        assert(rhs[symbolSize + i] == 0);
-      }
-
-      std::memcpy(symbols[Y].data(), rhs.data(), symbolSize);
       AddToDiag(diag, isAnti, Y, symbols[Y]);
       // We're about to do RDP, and it's going to restore X and Y.
       // We've just restored Y ourselves though.
@@ -292,59 +369,112 @@ bool CRTPProcessor::DecodeDataSymbols(
       }
     case 2: {  // RDP
       assert(X < Y);
-      auto r = p - 1;
-      for (unsigned const _ : iota(p - 1)) {
-        auto const d = DiagNum(isAnti, Y, r);
-        if (r != m_StripeUnitsPerSymbol) {
-          // Update the diagonal checksum after restoring Y[r] on the previous iteration
-          XOR(diag.data() + d * m_StripeUnitSize, symbols[Y].data() + r * m_StripeUnitSize,
-              m_StripeUnitSize);
-        }
-        r = (isAnti ? (p + X - d) : (p + d - X)) % p;
-        assert(DiagNum(isAnti, X, r) == d);
-        assert(r < m_StripeUnitsPerSymbol);
-        // Restore X[r] using a diagonal sum
-        {
-          auto const ax = symbols[X].data() + r * m_StripeUnitSize;
-          // ax is zeroed at this point, so we can memcpy instead of XORing
-          assert(d <= m_StripeUnitsPerSymbol);
-          auto const diag_sum = diag.data() + d * m_StripeUnitSize;
-          memcpy(ax, diag_sum, m_StripeUnitSize);
-          // We don't actually need to update the diagonal sum,
-          // because we aren't going to read it again.
-          // But if we had to, we could just zero it, because at this point the
-          // diagonal d should be completely restored.
-          // memset(diag_sum, 0, m_StripeUnitSize);
-        }
-        // Restore Y's row r with a row sum
-        {
-          auto const ay = symbols[Y].data() + r * m_StripeUnitSize;
-          for (std::size_t const s : iota(p)) {
-            if (s != Y) {
-              auto const as = symbols[s].data() + r * m_StripeUnitSize;
-              XOR(ay, as, m_StripeUnitSize);
-            }
-          }
-          // We will update the diagonal checksum at the start of the next iteration.
-        }
-      }
+      // The chain is walked in every lane independently
+      forEachLane(m_StripeUnitSize, [&](unsigned lane, std::size_t begin, std::size_t end) {
+        RestoreChain(X, Y, isAnti, symbols.data(), diag, ws.sources.data() + lane * p, begin,
+                     end - begin);
+      });
     } break;
     default: {  // RAID4
       assert(NumErasedRaid4Symbols == 1);
-      for (std::size_t const s : iota(p)) {
-        if (s != X) {
-          symbols[X] ^= symbols[s];
+      forEachLane(symbolSize, [&](unsigned lane, std::size_t begin, std::size_t end) {
+        auto* const sources = ws.sources.data() + lane * p;
+        auto n = 0u;
+        for (std::size_t const s : iota(p)) {
+          if (s != X) {
+            sources[n++] = symbols[s] + begin;
+          }
         }
-      }
+        XORN(symbols[X] + begin, sources, n, end - begin);
+      });
     } break;
   }
 
-  for (unsigned const symbolId : iota(FirstSymbolID, LastSymbolID)) {
-    memcpy(pDest, symbols[symbolId].data(), symbolSize);
-    pDest += symbolSize;
+  return ok;
+}
+
+void CRTPProcessor::RestoreChain(unsigned X,
+                                 unsigned Y,
+                                 bool isAnti,
+                                 unsigned char* const* symbols,
+                                 unsigned char* diag,
+                                 unsigned char const** rowSources,
+                                 std::size_t Offset,
+                                 std::size_t Size) const {
+  auto const unit = [this, Offset](unsigned char* base, unsigned i) {
+    return base + i * m_StripeUnitSize + Offset;
+  };
+  auto r = p - 1;
+  for (unsigned const _ : iota(p - 1)) {
+    auto const d = DiagNum(isAnti, Y, r);
+    if (r != m_StripeUnitsPerSymbol) {
+      // Update the diagonal checksum after restoring Y[r] on the previous iteration
+      XOR(unit(diag, d), unit(symbols[Y], r), Size);
+    }
+    r = (isAnti ? (p + X - d) : (p + d - X)) % p;
+    assert(DiagNum(isAnti, X, r) == d);
+    assert(r < m_StripeUnitsPerSymbol);
+    // Restore X[r] using a diagonal sum
+    {
+      // The diagonal sum includes everything but ax, so we can memcpy instead of XORing
+      assert(d <= m_StripeUnitsPerSymbol);
+      memcpy(unit(symbols[X], r), unit(diag, d), Size);
+      // We don't actually need to update the diagonal sum,
+      // because we aren't going to read it again.
+      // But if we had to, we could just zero it, because at this point the
+      // diagonal d should be completely restored.
+    }
+    // Restore Y's row r with a row sum
+    {
+      auto n = 0u;
+      for (std::size_t const s : iota(p)) {
+        if (s != Y) {
+          rowSources[n++] = unit(symbols[s], r);
+        }
+      }
+      XORN(unit(symbols[Y], r), rowSources, n, Size);
+      // We will update the diagonal checksum at the start of the next iteration.
+    }
   }
+}
 
-  return ok;
+void CRTPProcessor::RestoreMiddleSymbol(unsigned YX,
+                                        unsigned ZX,
+                                        unsigned char* rhs,
+                                        unsigned char* pairs,
+                                        unsigned char* y,
+                                        unsigned char const** sources,
+                                        std::size_t Offset,
+                                        std::size_t Size) const {
+  auto const unit = [this, Offset](unsigned char* base, unsigned i) {
+    return base + i * m_StripeUnitSize + Offset;
+  };
+  auto const u = YX;
+  auto const v = ZX - YX;
+  // P[k]+c, starting from P[p-1]+c=0
+  auto k = p - 1;
+  memset(unit(pairs, k), 0, Size);
+  for ([[maybe_unused]] unsigned const _ : iota(p - 1)) {
+    auto const next = (k + v) % p;
+    XOR(unit(pairs, k), unit(rhs, k), unit(pairs, next), Size);
+    k = next;
+  }
+  // The equation k is implied by the other ones, so its unit receives c=sum(P[i]+c), as p is odd
+  auto* const c = unit(rhs, k);
+  for (unsigned const i : iota(p)) {
+    sources[i] = unit(pairs, i);
+  }
+  XORN(c, sources, p, Size);
+  // Y[k+u]=Y[k]+P[k], starting from Y[p-1]=0
+  k = p - 1;
+  XOR(unit(pairs, k), c, unit(y, u - 1), Size);
+  k = u - 1;
+  for ([[maybe_unused]] unsigned const _ : iota(p - 2)) {
+    auto const next = (k + u) % p;
+    assert(next != p - 1);
+    XOR(unit(pairs, k), c, unit(y, k), unit(y, next), Size);
+    k = next;
+  }
 }
 
 bool CRTPProcessor::DecodeDataSubsymbols(unsigned long long int StripeID,
@@ -356,51 +486,304 @@ bool CRTPProcessor::DecodeDataSubsymbols(unsigned long long int StripeID,
                                          size_t ThreadID) {
   assert(SymbolID < m_Dimension);
   // If the symbol is OK, just read from it.
-  if (!IsErased(ErasureSetID, SymbolID)) {
-    return ReadStripeUnit(StripeID, ErasureSetID, SymbolID, SubsymbolID, Subsymbols2Decode, pDest);
+  if (!IsSymbolErased(ErasureSetID, SymbolID)) {
+    return ReadSubsymbols(StripeID, ErasureSetID, SymbolID, pDest, SubsymbolID, Subsymbols2Decode);
   }
   auto const NumErasedRAID4Symbols = GetNumErasedRaid4Symbols(ErasureSetID);
+  assert(ThreadID < m_Workspaces.size());
+  auto& ws = m_Workspaces[ThreadID];
 
   if (NumErasedRAID4Symbols == 1) {
       // We can use row parity
       auto const size = Subsymbols2Decode * m_StripeUnitSize;
-      auto read_buf = AlignedBuffer(size);
-      auto xor_buf = AlignedBuffer(size, true);
       auto ok = true;
+      auto n = 0u;
       for (std::size_t const s : iota(p)) {
-        if (s == SymbolID) {
+        if (s == SymbolID || IsVirtual(s)) {
           continue;
         }
-        assert(!IsErased(ErasureSetID, s));
-        ok &= ReadStripeUnit(StripeID, ErasureSetID, s, SubsymbolID, Subsymbols2Decode,
-                             read_buf.data());
-        xor_buf ^= read_buf;
+        assert(!IsSymbolErased(ErasureSetID, s));
+        auto const dst = ws.symbols[s].data();
+        ok &= ReadSubsymbols(StripeID, ErasureSetID, s, dst, SubsymbolID, Subsymbols2Decode);
+        ws.sources[n++] = dst;
       }
-      memcpy(pDest, xor_buf.data(), size);
+      XORN(pDest, ws.sources.data(), n, size);
       return ok;
     }
 
-  // No luck, we have to restore the entire symbol
-  auto symbol = AlignedBuffer(SymbolSize());
-  auto const ok = DecodeDataSymbols(StripeID, ErasureSetID, SymbolID, 1, symbol.data(), ThreadID);
+  if (NumErasedRAID4Symbols == 2) {
+    // Follow the row and diagonal chains from the requested units to their ends
+    return PeelSubsymbols(StripeID, ErasureSetID, SymbolID, SubsymbolID, Subsymbols2Decode, pDest,
+                          ws);
+  }
+
+  // No luck, three RAID4 symbols are erased, so we have to restore the entire symbol
+  auto const ok = RestoreSymbols(StripeID, ErasureSetID, SymbolID, SymbolID + 1, nullptr, ws);
   if (!ok) {
     return false;
   }
-  memcpy(pDest, symbol.data() + SubsymbolID * m_StripeUnitSize,
+  memcpy(pDest, ws.symbolData[SymbolID] + SubsymbolID * m_StripeUnitSize,
          Subsymbols2Decode * m_StripeUnitSize);
   return true;
 }
 
+bool CRTPProcessor::IsCorrectable(unsigned ErasureSetID) {
+  if (GetNumOfErasures(ErasureSetID) > 3) {
+    return false;
+  }
+  if (GetNumErasedRaid4Symbols(ErasureSetID) == 3) {
+    if (m_TripleDecoding == TripleDecoding::kClosedForm) {
+      return true;
+    }
+    auto const [X, Y, Z] = GetErasedSymbols(ErasureSetID);
+    auto const key = std::pair<unsigned, unsigned>(Y - X, Z - X);
+    if (!m_TriplePlans.contains(key)) {
+      m_TriplePlans.emplace(key, BuildTripleErasurePlan(key.first, key.second));
+    }
+  } else if (GetNumErasedRaid4Symbols(ErasureSetID) == 2) {
+    auto const erased = GetErasedSymbols(ErasureSetID);
+    if (!m_PeelingPlans.contains(erased)) {
+      m_PeelingPlans.emplace(erased, BuildPeelingPlan(erased));
+    }
+  }
+  return true;
+}
+
+unsigned CRTPProcessor::EquationRow(unsigned e, unsigned s) const {
+  auto const n = m_StripeUnitsPerSymbol;
+  assert(e < 3 * n && s < p);
+  if (e < n) {
+    return e;
+  } else if (e < 2 * n) {
+    return (p + (e - n) - s) % p;
+  } else {
+    return (s + p - (e - 2 * n)) % p;
+  }
+}
+
+/// Peel the erased units level by level: at each level, solve all the equations having
+/// a single unknown unit. This finds the shortest chains leading to each unit
+CRTPProcessor::PeelingPlan CRTPProcessor::BuildPeelingPlan(std::array<int, 3> const& erased) const {
+  auto const n = m_StripeUnitsPerSymbol;
+  auto const isErased = [&erased](unsigned s) {
+    return std::find(erased.begin(), erased.end(), static_cast<int>(s)) != erased.end();
+  };
+  // Diagonal equations are available only if the corresponding parity symbol is
+  auto const isAvailable = [&](unsigned e) { return e < n || !isErased(ParityDisk(e)); };
+
+  auto plan = PeelingPlan{.solver = std::vector<int>(p * n, -1),
+                          .order = std::vector<unsigned>(p * n, 0)};
+  auto unknowns = std::vector<unsigned>(3 * n, 0);
+  auto current = std::vector<unsigned>();
+  for (unsigned const e : iota(3 * n)) {
+    if (!isAvailable(e)) {
+      continue;
+    }
+    for (unsigned const s : iota(p)) {
+      if (isErased(s) && EquationRow(e, s) < n) {
+        unknowns[e]++;
+      }
+    }
+    if (unknowns[e] == 1) {
+      current.push_back(e);
+    }
+  }
+
+  auto solved = std::vector<bool>(p * n, false);
+  auto sequence = 0u;
+  while (!current.empty()) {
+    auto newlySolved = std::vector<unsigned>();
+    for (unsigned const e : current) {
+      // The unknown may have been solved by another equation at this level
+      for (unsigned const s : iota(p)) {
+        auto const j = EquationRow(e, s);
+        if (isErased(s) && j < n && !solved[s * n + j]) {
+          auto const u = s * n + j;
+          solved[u] = true;
+          plan.solver[u] = e;
+          plan.order[u] = sequence++;
+          newlySolved.push_back(u);
+          break;
+        }
+      }
+    }
+    current.clear();
+    for (unsigned const u : newlySolved) {
+      auto const s = u / n;
+      auto const j = u % n;
+      auto const d = static_cast<unsigned>(DiagNum(false, s, j));
+      auto const ad = static_cast<unsigned>(DiagNum(true, s, j));
+      // The unit lies on the missing diagonal if d == n or ad == n
+      for (unsigned const e : {j, (d < n) ? n + d : 3 * n, (ad < n) ? 2 * n + ad : 3 * n}) {
+        if (e < 3 * n && isAvailable(e) && --unknowns[e] == 1) {
+          current.push_back(e);
+        }
+      }
+    }
+  }
+  return plan;
+}
+
+bool CRTPProcessor::PeelSubsymbols(unsigned long long StripeID,
+                                   unsigned ErasureSetID,
+                                   unsigned SymbolID,
+                                   unsigned SubsymbolID,
+                                   unsigned Subsymbols2Decode,
+                                   unsigned char* pDest,
+                                   Workspace& ws) {
+  auto const n = m_StripeUnitsPerSymbol;
+  auto const& plan = m_PeelingPlans.at(GetErasedSymbols(ErasureSetID));
+  auto const unitPtr = [this, &ws, n](unsigned disk, unsigned j) -> unsigned char* {
+    auto* const base = (disk < p) ? ws.symbols[disk].data() : (disk == p) ? ws.diag.data()
+                                                                         : ws.adiag.data();
+    assert(j < n);
+    return base + j * m_StripeUnitSize;
+  };
+
+  // Collect the equations needed for the requested units, and mark the units they involve
+  auto& involved = ws.involved;
+  std::fill(involved.begin(), involved.end(), 0);
+  auto& pending = ws.pending;
+  auto& needed = ws.needed;
+  pending.clear();
+  needed.clear();
+  for (unsigned const j : iota(SubsymbolID, SubsymbolID + Subsymbols2Decode)) {
+    pending.push_back(SymbolID * n + j);
+    involved[SymbolID * n + j] = 1;
+  }
+  while (!pending.empty()) {
+    auto const u = pending.back();
+    pending.pop_back();
+    assert(plan.solver[u] >= 0);
+    auto const e = static_cast<unsigned>(plan.solver[u]);
+    needed.push_back(u);
+    for (unsigned const s : iota(p)) {
+      auto const j = EquationRow(e, s);
+      if (j < n && !involved[s * n + j]) {
+        involved[s * n + j] = 1;
+        if (IsSymbolErased(ErasureSetID, s)) {
+          pending.push_back(s * n + j);
+        }
+      }
+    }
+    if (e >= n) {
+      involved[ParityDisk(e) * n + e % n] = 1;
+    }
+  }
+
+  // Read the involved units, coalescing contiguous runs on each disk
+  auto ok = true;
+  for (unsigned const disk : iota(p + 2)) {
+    if (IsSymbolErased(ErasureSetID, disk)) {
+      continue;
+    }
+    for (unsigned j = 0; j < n;) {
+      if (!involved[disk * n + j]) {
+        j++;
+        continue;
+      }
+      auto const start = j;
+      while (j < n && involved[disk * n + j]) {
+        j++;
+      }
+      ok &= ReadSubsymbols(StripeID, ErasureSetID, disk, unitPtr(disk, start), start, j - start);
+    }
+  }
+
+  // Solve the equations in the order they were peeled
+  std::sort(needed.begin(), needed.end(),
+            [&plan](unsigned a, unsigned b) { return plan.order[a] < plan.order[b]; });
+  auto* const sources = ws.sources.data();
+  for (unsigned const u : needed) {
+    auto const e = static_cast<unsigned>(plan.solver[u]);
+    auto k = 0u;
+    for (unsigned const s : iota(p)) {
+      auto const j = EquationRow(e, s);
+      if (s != u / n && j < n) {
+        sources[k++] = unitPtr(s, j);
+      }
+    }
+    if (e >= n) {
+      sources[k++] = unitPtr(ParityDisk(e), e % n);
+    }
+    XORN(unitPtr(u / n, u % n), sources, k, m_StripeUnitSize);
+  }
+
+  memcpy(pDest, unitPtr(SymbolID, SubsymbolID), Subsymbols2Decode * m_StripeUnitSize);
+  return ok;
+}
+
+/// Run Gaussian elimination on the system of equations for Y, keeping track of
+/// the combination of the original right-hand side rows that ends up in each row
+CRTPProcessor::TripleErasurePlan CRTPProcessor::BuildTripleErasurePlan(unsigned YX,
+                                                                         unsigned ZX) const {
+  auto lhs = std::vector(p, std::vector(p - 1, false));
+  auto comb = std::vector(p, std::vector(p, false));
+  for (unsigned const k : iota(p)) {
+    for (unsigned const c : {k, k + (ZX - YX), k + YX, k + ZX}) {
+      auto const i = c % p;
+      if (i != p - 1) {
+        lhs[k][i].flip();
+      }
+    }
+    comb[k][k] = true;
+  }
+
+  for (unsigned const r : iota(p - 1)) {
+    if (!lhs[r][r]) {
+      for (unsigned const other : iota(r + 1, p)) {
+        if (lhs[other][r]) {
+          std::swap(lhs[r], lhs[other]);
+          std::swap(comb[r], comb[other]);
+          break;
+        }
+      }
+    }
+
+    assert(lhs[r][r]);
+    for (unsigned const other : iota(p)) {
+      if (r != other && lhs[other][r]) {
+        lhs[other] ^= lhs[r];
+        comb[other] ^= comb[r];
+      }
+    }
+  }
+
+  for ([[maybe_unused]] unsigned const r : iota(p)) {
+    for ([[maybe_unused]] unsigned const c : iota(p - 1)) {
+      assert((r == c) == lhs[r][c]);
+    }
+  }
+
+  auto plan = TripleErasurePlan();
+  plan.start.reserve(p);
+  for (unsigned const r : iota(p - 1)) {
+    plan.start.push_back(plan.rows.size());
+    for (unsigned const c : iota(p)) {
+      if (comb[r][c]) {
+        plan.rows.push_back(c);
+      }
+    }
+  }
+  plan.start.push_back(plan.rows.size());
+  return plan;
+}
+
 unsigned int CRTPProcessor::GetNumErasedRaid4Symbols(unsigned int ErasureSetID) const {
-  return GetNumOfErasures(ErasureSetID) - IsErased(ErasureSetID, p) - IsErased(ErasureSetID, p + 1);
+  return GetNumOfErasures(ErasureSetID) - IsSymbolErased(ErasureSetID, p) -
+         IsSymbolErased(ErasureSetID, p + 1);
 }
 
 std::array<int, 3> CRTPProcessor::GetErasedSymbols(unsigned int ErasureSetID) const {
   auto result = std::array{GetErasedPosition(ErasureSetID, 0), GetErasedPosition(ErasureSetID, 1),
                            GetErasedPosition(ErasureSetID, 2)};
   auto const n = GetNumOfErasures(ErasureSetID);
-  for ([[maybe_unused]] unsigned const i : iota(3)) {
+  for (unsigned const i : iota(3)) {
     assert((i < n) ? (result[i] >= 0) : (result[i] == -1));
+    // The check symbols of a shortened code are stored right after its data symbols
+    if (result[i] >= static_cast<int>(m_Dimension)) {
+      result[i] += p - 1 - m_Dimension;
+    }
   }
   switch (n) {
     case 3:
@@ -431,65 +814,140 @@ bool CRTPProcessor::EncodeStripe(unsigned long long StripeID,  /// the stripe to
 ) {
   assert(IsCorrectable(ErasureSetID));
   auto ok = true;
-  auto const write_symbol = [=, this, &ok](std::size_t symbolId, AlignedBuffer const& symbol) {
-    if (!IsErased(ErasureSetID, symbolId)) {
+  auto const write_symbol = [=, this, &ok](std::size_t symbolId, unsigned char const* symbol) {
+    if (!IsSymbolErased(ErasureSetID, symbolId)) {
       ok &= WriteSymbol(StripeID, ErasureSetID, symbolId, symbol);
     }
   };
   auto const symbol_size = SymbolSize();
-  auto buffer = AlignedBuffer(symbol_size);
-  auto row = AlignedBuffer(symbol_size, true);
-  auto diag = AlignedBuffer(symbol_size, true);
-  auto adiag = AlignedBuffer(symbol_size, true);
+  assert(ThreadID < m_Workspaces.size());
+  auto& ws = m_Workspaces[ThreadID];
+  auto* const row = ws.row.data();
+  auto* const diag = ws.diag.data();
+  auto* const adiag = ws.adiag.data();
+  // The unstored diagonals are accumulated past symbol_size and ignored
+  memset(row, 0, symbol_size);
+  memset(diag, 0, symbol_size);
+  memset(adiag, 0, symbol_size);
   for (std::size_t const symbolId : iota(m_Dimension)) {
-    memcpy(buffer.data(), pData + symbolId * symbol_size, symbol_size);
-    auto const& symbol = buffer;
+    auto const* symbol = pData + symbolId * symbol_size;
     write_symbol(symbolId, symbol);
-    row ^= symbol;
-    AddToDiags(diag, adiag, symbolId, symbol);
+    AddToChains(row, diag, adiag, symbolId, symbol);
   }
-  AddToDiags(diag, adiag, p - 1, row);
+  AddToChains(nullptr, diag, adiag, p - 1, row);
   write_symbol(p - 1, row);
   write_symbol(p, diag);
   write_symbol(p + 1, adiag);
   return ok;
 }
 
-bool CRTPProcessor::GetEncodingStrategy(unsigned int ErasureSetID,
-                                        unsigned int StripeUnitID,
-                                        unsigned int Subsymbols2Encode) {
-  assert(StripeUnitID + Subsymbols2Encode <= m_Dimension * m_StripeUnitsPerSymbol);
-  constexpr auto READ_WRITE = true;
-  constexpr auto UPDATE = false;
-  // If all the checksum disks are erased, there's nothing to talk about.
-  // Just update the symbols.
-  if (IsErased(ErasureSetID, p - 1) && IsErased(ErasureSetID, p) && IsErased(ErasureSetID, p + 1)) {
-    return UPDATE;
-  }
-  auto const from_subsymbol = StripeUnitID;
-  auto const from_symbol = from_subsymbol / m_StripeUnitsPerSymbol;
-  auto const to_subsymbol = StripeUnitID + Subsymbols2Encode;
-  assert(Subsymbols2Encode != 0);
-  auto const to_symbol = (to_subsymbol - 1) / m_StripeUnitsPerSymbol + 1;
-  assert(to_symbol * m_StripeUnitSize >= to_subsymbol);
-  for (unsigned const disk : iota(from_symbol, to_symbol)) {
-    // If any of the target disks is erased, we would have to restore original contents,
-    // which is likely to cause the entire codeword to be read.
-    if (IsErased(ErasureSetID, disk)) {
-      return READ_WRITE;
-    }
-  }
-  for (unsigned const i : iota(from_subsymbol, to_subsymbol)) {
-    [[maybe_unused]] auto const symbol = i / m_StripeUnitsPerSymbol;
-    assert(from_symbol <= symbol && symbol < to_symbol);
-  }
-  if (4 * Subsymbols2Encode < 3 * m_StripeUnitsPerSymbol * m_Dimension) {
-    return UPDATE;
-  } else {
-    return READ_WRITE;
+void CRTPProcessor::MarkTouchedUnits(unsigned StripeUnitID,
+                                     unsigned Units2Update,
+                                     unsigned char* touched) const {
+  auto const n = m_StripeUnitsPerSymbol;
+  std::fill(touched, touched + 3 * n, 0);
+  auto const mark_diags = [this, touched, n](unsigned i) {
+    // The unstored diagonal is numbered n, and its flags are never looked at
+    if (auto const d = m_DiagNums[i]; d < n) {
+      touched[n + d] = 1;
+    }
+    if (auto const ad = m_AntiDiagNums[i]; ad < n) {
+      touched[2 * n + ad] = 1;
+    }
+  };
+  // Data unit i is subsymbol i % n of symbol i / n, so i indexes the tables directly
+  for (unsigned const i : iota(StripeUnitID, StripeUnitID + Units2Update)) {
+    touched[i % n] = 1;
+    mark_diags(i);
+  }
+  // The row parity symbol contributes the row deltas to its own chains
+  for (unsigned const j : iota(n)) {
+    if (touched[j]) {
+      mark_diags((p - 1) * n + j);
+    }
   }
 }
 
+unsigned CRTPProcessor::GetSubsymbolDecodingCost(unsigned ErasureSetID,
+                                                 unsigned SymbolID,
+                                                 unsigned Subsymbols2Decode) const {
+  if (!IsSymbolErased(ErasureSetID, SymbolID)) {
+    return Subsymbols2Decode;
+  }
+  if (GetNumErasedRaid4Symbols(ErasureSetID) == 1) {
+    // The rest of the rows
+    return m_Dimension * Subsymbols2Decode;
+  }
+  // Peeling and full restoration read at most all the surviving symbols
+  return (m_Length - GetNumOfErasures(ErasureSetID)) * m_StripeUnitsPerSymbol;
+}
+
+unsigned CRTPProcessor::GetReadCost(unsigned ErasureSetID,
+                                    unsigned StripeUnitID,
+                                    unsigned NumOfUnits,
+                                    [[maybe_unused]] size_t ThreadID) {
+  if (!NumOfUnits) {
+    return 0;
+  }
+  auto const n = m_StripeUnitsPerSymbol;
+  unsigned cost = 0;
+  // ReadData passes the partial symbols at both ends to DecodeDataSubsymbols,
+  // and the whole symbols to a single DecodeDataSymbols call
+  unsigned wholeUnits = 0;
+  bool wholeErased = false;
+  for (unsigned const s : iota(StripeUnitID / n, (StripeUnitID + NumOfUnits - 1) / n + 1)) {
+    auto const start = std::max(StripeUnitID, s * n) - s * n;
+    auto const end = std::min(StripeUnitID + NumOfUnits, (s + 1) * n) - s * n;
+    if (end - start < n) {
+      cost += GetSubsymbolDecodingCost(ErasureSetID, s, end - start);
+    } else {
+      wholeUnits += n;
+      wholeErased |= IsSymbolErased(ErasureSetID, s);
+    }
+  }
+  // RestoreSymbols reads all the surviving symbols
+  return cost + (wholeErased ? (m_Length - GetNumOfErasures(ErasureSetID)) * n : wholeUnits);
+}
+
+bool CRTPProcessor::GetUpdateCost(unsigned ErasureSetID,
+                                  unsigned StripeUnitID,
+                                  unsigned Units2Update,
+                                  IOCost& Cost,
+                                  size_t ThreadID) {
+  assert(Units2Update != 0);
+  assert(StripeUnitID + Units2Update <= m_Dimension * m_StripeUnitsPerSymbol);
+  auto const n = m_StripeUnitsPerSymbol;
+  assert(ThreadID < m_Workspaces.size());
+  auto& touched = m_Workspaces[ThreadID].loaded;
+  MarkTouchedUnits(StripeUnitID, Units2Update, touched.data());
+  unsigned parityUnits = 0;
+  for (unsigned const c : iota(3u)) {
+    if (!IsSymbolErased(ErasureSetID, p - 1 + c)) {
+      parityUnits += std::count(touched.begin() + c * n, touched.begin() + (c + 1) * n, 1);
+    }
+  }
+  // The old data is not needed if all the checksum disks are erased
+  if (!parityUnits) {
+    Cost.Reads = 0;
+    Cost.Writes = Units2Update;
+    return true;
+  }
+  // The old contents of erased symbols are decoded, and the new ones are not written
+  unsigned dataReads = 0;
+  unsigned dataWrites = 0;
+  for (unsigned const s : iota(StripeUnitID / n, (StripeUnitID + Units2Update - 1) / n + 1)) {
+    auto const count =
+        std::min(StripeUnitID + Units2Update, (s + 1) * n) - std::max(StripeUnitID, s * n);
+    dataReads += GetSubsymbolDecodingCost(ErasureSetID, s, count);
+    if (!IsSymbolErased(ErasureSetID, s)) {
+      dataWrites += count;
+    }
+  }
+  Cost.Reads = dataReads + parityUnits;
+  Cost.Writes = dataWrites + parityUnits;
+  return true;
+}
+
 /// update some information symbols and the corresponding check symbols
 ///@return true on success
 bool CRTPProcessor::UpdateInformationSymbols(
@@ -500,131 +958,159 @@ bool CRTPProcessor::UpdateInformationSymbols(
     const unsigned char* pData,   /// new payload data symbols
     size_t ThreadID               /// the ID of the calling thread
 ) {
-  auto const symbolSize = SymbolSize();
+  assert(Units2Update != 0);
   bool ok = true;
+  auto const n = m_StripeUnitsPerSymbol;
+  auto const unitSize = m_StripeUnitSize;
+  auto const firstSymbol = StripeUnitID / n;
+  auto const lastSymbol = (StripeUnitID + Units2Update - 1) / n + 1;
+  assert(lastSymbol <= m_Dimension);
+  // The updated units of each symbol form a single run [runStart(s), runEnd(s))
+  auto const runStart = [=](unsigned s) -> unsigned {
+    return (s == firstSymbol) ? StripeUnitID % n : 0;
+  };
+  auto const runEnd = [=](unsigned s) -> unsigned {
+    return std::min(n, StripeUnitID + Units2Update - s * n);
+  };
+  auto const newData = [=](unsigned s) {
+    return pData + (s * n + runStart(s) - StripeUnitID) * unitSize;
+  };
+  auto const write_data = [&]() {
+    for (unsigned const s : iota(firstSymbol, lastSymbol)) {
+      // The new contents of erased symbols are represented by the parity only
+      if (IsSymbolErased(ErasureSetID, s)) {
+        continue;
+      }
+      ok &= WriteSubsymbols(StripeID, ErasureSetID, s, newData(s), runStart(s),
+                            runEnd(s) - runStart(s));
+    }
+  };
 
   // If all the checksum disks are erased, there's nothing to talk about.
   // Just update the symbols.
-  if (IsErased(ErasureSetID, p - 1) && IsErased(ErasureSetID, p) && IsErased(ErasureSetID, p + 1)) {
-    for (unsigned const offset : iota(Units2Update)) {
-      auto const i = StripeUnitID + offset;
-      auto const symbol = i / m_StripeUnitsPerSymbol;
-      auto const subSymbol = i % m_StripeUnitsPerSymbol;
-      assert(!IsErased(ErasureSetID, symbol));
-      assert(symbol < m_Dimension);
-      ok &= WriteSubsymbols(StripeID, ErasureSetID, symbol, pData, subSymbol, 1);
-      pData += m_StripeUnitSize;
-    }
+  if (IsSymbolErased(ErasureSetID, p - 1) && IsSymbolErased(ErasureSetID, p) &&
+      IsSymbolErased(ErasureSetID, p + 1)) {
+    write_data();
     return ok;
   }
 
-  struct LazyChecksum {
-    AlignedBuffer checksum;
-    std::vector<bool> initialized;
-    unsigned disk;
-  };
+  assert(ThreadID < m_Workspaces.size());
+  auto& ws = m_Workspaces[ThreadID];
+  // The old contents of erased target symbols are recovered from the chains passing through
+  // them. This is done first, since the decoder shares the workspace
+  auto const symbolSize = SymbolSize();
+  auto* erasedData = ws.erasedData.data();
+  for (unsigned const s : iota(firstSymbol, lastSymbol)) {
+    if (IsSymbolErased(ErasureSetID, s)) {
+      ok &= DecodeDataSubsymbols(StripeID, ErasureSetID, s, runStart(s), runEnd(s) - runStart(s),
+                                 erasedData + runStart(s) * unitSize, ThreadID);
+      erasedData += symbolSize;
+    }
+  }
+  // The old data, and then the data deltas, of target symbol s are kept in ws.symbolData[s]
+  auto& oldData = ws.symbolData;
+  erasedData = ws.erasedData.data();
+  for (unsigned const s : iota(firstSymbol, lastSymbol)) {
+    if (IsSymbolErased(ErasureSetID, s)) {
+      oldData[s] = erasedData;
+      erasedData += symbolSize;
+    } else {
+      oldData[s] = ws.symbols[s].data();
+    }
+  }
 
-  auto const init_lazy_checksum = [this, symbolSize](unsigned const pos) -> LazyChecksum {
-    return LazyChecksum{.checksum = AlignedBuffer(symbolSize),
-                        .initialized = std::vector<bool>(m_StripeUnitsPerSymbol),
-                        .disk = pos};
-  };
-  auto const maybe_init_lazy_checksum = [this, ErasureSetID,
-                                         &init_lazy_checksum](unsigned const pos) -> LazyChecksum {
-    return IsErased(ErasureSetID, pos) ? LazyChecksum{.checksum = AlignedBuffer(),
-                                                      .initialized = std::vector<bool>(),
-                                                      .disk = pos}
-                                       : init_lazy_checksum(pos);
-  };
+  // Checksum c is stored on disk p-1+c. Its updated units are marked in touched[c*n..(c+1)*n),
+  // and the units themselves are read into checksums[c], unless the disk is erased
+  auto* const touched = ws.loaded.data();
+  MarkTouchedUnits(StripeUnitID, Units2Update, touched);
+  std::array<unsigned char*, 3> const checksums{ws.row.data(), ws.diag.data(), ws.adiag.data()};
+  std::array<bool, 3> const tracked{!IsSymbolErased(ErasureSetID, p - 1),
+                                    !IsSymbolErased(ErasureSetID, p),
+                                    !IsSymbolErased(ErasureSetID, p + 1)};
+  // The row deltas are needed to update the diagonals even if the row parity is erased
+  auto* const rowDelta = ws.rhs.data();
+  for (unsigned const j : iota(n)) {
+    if (touched[j]) {
+      memset(rowDelta + j * unitSize, 0, unitSize);
+    }
+  }
 
-  auto row = init_lazy_checksum(p - 1);
-  auto diag = maybe_init_lazy_checksum(p);
-  auto adiag = maybe_init_lazy_checksum(p + 1);
-
-  auto const add_to_diag = [this, &ok, symbolSize, StripeID, ErasureSetID](
-                               LazyChecksum& lazyChecksum, unsigned pos, unsigned char const* src) {
-    auto& [checksum, initialized, checksumDisk] = lazyChecksum;
-    if (!checksum.size()) {
-      assert(initialized.empty());
-      return;
-    }
-    assert(checksum.size() == symbolSize);
-    assert(initialized.size() == m_StripeUnitsPerSymbol);
-    if (pos >= initialized.size()) {
-      assert(pos == m_StripeUnitsPerSymbol);
-      return;
-    }
-    auto const dst = checksum.data() + pos * m_StripeUnitSize;
-    if (!initialized[pos]) {
-      ok &= ReadSubsymbols(StripeID, ErasureSetID, checksumDisk, dst, pos, 1);
-      initialized[pos] = true;
-    }
-    XOR(dst, src, m_StripeUnitSize);
+  // call fn(start, count) for each maximal run of marked units
+  auto const for_each_run = [n](unsigned char const* flags, auto&& fn) {
+    for (unsigned start = 0; start < n;) {
+      if (!flags[start]) {
+        ++start;
+        continue;
+      }
+      auto end = start + 1;
+      while (end < n && flags[end]) {
+        ++end;
+      }
+      fn(start, end - start);
+      start = end;
+    }
   };
 
-  auto buf = AlignedBuffer(m_StripeUnitSize);
-  for (unsigned const offset : iota(Units2Update)) {
-    auto const i = StripeUnitID + offset;
-    auto const symbol = i / m_StripeUnitsPerSymbol;
-    auto const subSymbol = i % m_StripeUnitsPerSymbol;
-    assert(!IsErased(ErasureSetID, symbol));
-    assert(symbol < m_Dimension);
-    auto const d = DiagNum(false, symbol, subSymbol);
-    auto const ad = DiagNum(true, symbol, subSymbol);
-    ok &= ReadSubsymbols(StripeID, ErasureSetID, symbol, buf.data(), subSymbol, 1);
-    XOR(buf.data(), pData, m_StripeUnitSize);
-    auto const row_dst = row.checksum.data() + subSymbol * m_StripeUnitSize;
-    if (row.initialized[subSymbol]) {
-      XOR(row_dst, buf.data(), m_StripeUnitSize);
-    } else {
-      memcpy(row_dst, buf.data(), m_StripeUnitSize);
-      row.initialized[subSymbol] = true;
+  // Gather: the old data units and the parity units, one request per contiguous run
+  for (unsigned const s : iota(firstSymbol, lastSymbol)) {
+    if (!IsSymbolErased(ErasureSetID, s)) {
+      ok &= ReadSubsymbols(StripeID, ErasureSetID, s, oldData[s] + runStart(s) * unitSize,
+                           runStart(s), runEnd(s) - runStart(s));
+    }
+  }
+  for (unsigned const c : iota(3u)) {
+    if (tracked[c]) {
+      for_each_run(touched + c * n, [&](unsigned start, unsigned count) {
+        ok &= ReadSubsymbols(StripeID, ErasureSetID, p - 1 + c, checksums[c] + start * unitSize,
+                             start, count);
+      });
     }
-    add_to_diag(diag, d, buf.data());
-    add_to_diag(adiag, ad, buf.data());
-    ok &= WriteSubsymbols(StripeID, ErasureSetID, symbol, pData, subSymbol, 1);
-    pData += m_StripeUnitSize;
   }
 
-  for (unsigned const i : iota(m_StripeUnitsPerSymbol)) {
-    if (row.initialized[i]) {
-      auto const d = DiagNum(false, row.disk, i);
-      auto const ad = DiagNum(true, row.disk, i);
-      auto const src = row.checksum.data() + i * m_StripeUnitSize;
-      add_to_diag(diag, d, src);
-      add_to_diag(adiag, ad, src);
-    }
-  }
-
-  auto const write_diag = [this, &ok, symbolSize, StripeID,
-                           ErasureSetID](LazyChecksum const& lazyChecksum) {
-    auto& [checksum, initialized, checksumDisk] = lazyChecksum;
-    if (!checksum.size()) {
-      assert(initialized.empty());
-      return;
-    }
-    assert(!IsErased(ErasureSetID, checksumDisk));
-    assert(checksum.size() == symbolSize);
-    assert(initialized.size() == m_StripeUnitsPerSymbol);
-    for (unsigned const i : iota(m_StripeUnitsPerSymbol)) {
-      if (initialized[i]) {
-        ok &= WriteSubsymbols(StripeID, ErasureSetID, checksumDisk,
-                              checksum.data() + i * m_StripeUnitSize, i, 1);
-      }
+  // Compute: each data delta goes to its row delta, diagonal and anti-diagonal,
+  // and each row delta goes to the row parity and to the chains of the row parity symbol
+  std::array<unsigned char*, 3> dests;
+  auto const add_delta = [&](unsigned s, unsigned j, unsigned char* rowDest,
+                             unsigned char const* delta) {
+    unsigned count = 0;
+    if (rowDest) {
+      dests[count++] = rowDest;
+    }
+    if (auto const d = m_DiagNums[s * n + j]; tracked[1] && d < n) {
+      dests[count++] = checksums[1] + d * unitSize;
+    }
+    if (auto const ad = m_AntiDiagNums[s * n + j]; tracked[2] && ad < n) {
+      dests[count++] = checksums[2] + ad * unitSize;
+    }
+    if (count) {
+      XORScatter(delta, dests.data(), count, unitSize);
     }
   };
+  for (unsigned const s : iota(firstSymbol, lastSymbol)) {
+    auto* const delta = oldData[s];
+    auto const start = runStart(s);
+    XOR(delta + start * unitSize, newData(s), (runEnd(s) - start) * unitSize);
+    for (unsigned const j : iota(start, runEnd(s))) {
+      add_delta(s, j, rowDelta + j * unitSize, delta + j * unitSize);
+    }
+  }
+  for (unsigned const j : iota(n)) {
+    if (touched[j]) {
+      add_delta(p - 1, j, tracked[0] ? checksums[0] + j * unitSize : nullptr,
+                rowDelta + j * unitSize);
+    }
+  }
 
-  if (!IsErased(ErasureSetID, row.disk)) {
-    for (unsigned const i : iota(m_StripeUnitsPerSymbol)) {
-      if (row.initialized[i]) {
-        ok &= ReadSubsymbols(StripeID, ErasureSetID, row.disk, buf.data(), i, 1);
-        XOR(buf.data(), row.checksum.data() + i * m_StripeUnitSize, m_StripeUnitSize);
-        ok &= WriteSubsymbols(StripeID, ErasureSetID, row.disk, buf.data(), i, 1);
-      }
+  // Scatter: the new data and the updated parity units, one request per contiguous run
+  write_data();
+  for (unsigned const c : iota(3u)) {
+    if (tracked[c]) {
+      for_each_run(touched + c * n, [&](unsigned start, unsigned count) {
+        ok &= WriteSubsymbols(StripeID, ErasureSetID, p - 1 + c, checksums[c] + start * unitSize,
+                              start, count);
+      });
     }
   }
-  write_diag(diag);
-  write_diag(adiag);
 
   return ok;
 }
@@ -639,46 +1125,78 @@ bool CRTPProcessor::CheckCodeword(unsigned long long StripeID,  /// the stripe t
     return true;
   }
   auto const symbol_size = SymbolSize();
-  auto buffer = AlignedBuffer(symbol_size);
-  auto read_symbol = [this, StripeID, ErasureSetID,
-                      &buffer](std::size_t symbolId) -> AlignedBuffer const& {
+  auto const read_symbol = [this, StripeID, ErasureSetID](std::size_t symbolId,
+                                                          unsigned char* buffer) {
     auto ok = ReadSymbol(StripeID, ErasureSetID, symbolId, buffer);
     if (!ok) {
       throw std::runtime_error("Error reading data");
     }
-    return buffer;
   };
-  auto row = AlignedBuffer(symbol_size, true);
-  auto diag = AlignedBuffer(symbol_size, true);
-  auto adiag = AlignedBuffer(symbol_size, true);
+  assert(ThreadID < m_Workspaces.size());
+  auto& ws = m_Workspaces[ThreadID];
+  auto* const row = ws.row.data();
+  auto* const diag = ws.diag.data();
+  auto* const adiag = ws.adiag.data();
+  // The unstored diagonals are accumulated past symbol_size and ignored
+  memset(row, 0, symbol_size);
+  memset(diag, 0, symbol_size);
+  memset(adiag, 0, symbol_size);
 
+  // The row sum includes the row parity, so it must be zero
   for (std::size_t const symbolId : iota(p)) {
-    auto const& symbol = read_symbol(symbolId);
-    row ^= symbol;
-    AddToDiags(diag, adiag, symbolId, symbol);
+    if (IsVirtual(symbolId)) {
+      continue;
+    }
+    auto* const symbol = ws.symbols[symbolId].data();
+    read_symbol(symbolId, symbol);
+    AddToChains(row, diag, adiag, symbolId, symbol);
+  }
+  if (!IsZero(row, symbol_size)) {
+    return false;
   }
-  return row.isZero() && diag == read_symbol(p) && adiag == read_symbol(p + 1);
+  auto* const buffer = ws.rhs.data();
+  read_symbol(p, buffer);
+  if (!Equal(diag, buffer, symbol_size)) {
+    return false;
+  }
+  read_symbol(p + 1, buffer);
+  return Equal(adiag, buffer, symbol_size);
 }
 
-void CRTPProcessor::AddToDiag(AlignedBuffer& diag,
+void CRTPProcessor::AddToDiag(unsigned char* diag,
                               bool isAnti,
                               std::size_t symbolId,
-                              const AlignedBuffer& symbol) const {
-  assert(diag.size() == SymbolSize() || diag.size() == SymbolSize() + m_StripeUnitSize);
-  for (std::size_t subsymbolID = 0; subsymbolID < m_StripeUnitsPerSymbol; ++subsymbolID) {
-    auto const d = DiagNum(isAnti, symbolId, subsymbolID);
-    assert(d <= m_StripeUnitsPerSymbol);
-    auto const offset = d * m_StripeUnitSize;
-    if (offset < diag.size()) {
-      XOR(&diag[offset], &symbol[subsymbolID * m_StripeUnitSize], m_StripeUnitSize);
-    }
+                              unsigned char const* symbol) const {
+  assert(symbolId < p);
+  auto const* offsets =
+      (isAnti ? m_AntiDiagOffsets : m_DiagOffsets).data() + symbolId * m_StripeUnitsPerSymbol;
+  for (unsigned const j : iota(m_StripeUnitsPerSymbol)) {
+    XOR(diag + offsets[j], symbol + j * m_StripeUnitSize, m_StripeUnitSize);
   }
 }
 
-void CRTPProcessor::AddToDiags(AlignedBuffer& diag,
-                               AlignedBuffer& adiag,
-                               std::size_t symbolId,
-                               const AlignedBuffer& symbol) const {
-  AddToDiag(diag, false, symbolId, symbol);
-  AddToDiag(adiag, true, symbolId, symbol);
+void CRTPProcessor::RestoreMissingDiag(unsigned char* diag, unsigned char const** sources) const {
+  // The sum of all diagonals is equal to the sum of all RAID4 symbols, which is zero
+  for (unsigned const i : iota(m_StripeUnitsPerSymbol)) {
+    sources[i] = diag + i * m_StripeUnitSize;
+  }
+  XORN(diag + SymbolSize(), sources, m_StripeUnitsPerSymbol, m_StripeUnitSize);
+}
+
+void CRTPProcessor::AddToChains(unsigned char* row,
+                                unsigned char* diag,
+                                unsigned char* adiag,
+                                std::size_t symbolId,
+                                unsigned char const* symbol) const {
+  assert(symbolId < p);
+  auto const* diagOffsets = m_DiagOffsets.data() + symbolId * m_StripeUnitsPerSymbol;
+  auto const* antiDiagOffsets = m_AntiDiagOffsets.data() + symbolId * m_StripeUnitsPerSymbol;
+  unsigned char* dest[3];
+  for (unsigned const j : iota(m_StripeUnitsPerSymbol)) {
+    auto const offset = j * m_StripeUnitSize;
+    dest[0] = diag + diagOffsets[j];
+    dest[1] = adiag + antiDiagOffsets[j];
+    dest[2] = row + offset;
+    XORScatter(symbol + offset, dest, row ? 3 : 2, m_StripeUnitSize);
+  }
 }
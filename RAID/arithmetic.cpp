@@ -11,23 +11,23 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cstring>
-#include <cstdint>
 #include <cassert>
 #include <emmintrin.h>
 #include <immintrin.h>
 #include "arithmetic.h"
+#include "kernels.h"
 #include "misc.h"
 
 using namespace std;    
-/** Get the pointer aligned to ARITHMETIC_ALIGNMENT boundary
+/** Get the pointer aligned to MEMORY_ALIGNMENT boundary
 */
 unsigned char* AlignedMalloc ( size_t Size )
 {
 #ifdef _WIN32
-    return ( unsigned char* ) _aligned_malloc ( Size,ARITHMETIC_ALIGNMENT );
+    return ( unsigned char* ) _aligned_malloc ( Size,MEMORY_ALIGNMENT );
 #else
     void* pResult;
-    if ( posix_memalign ( &pResult,ARITHMETIC_ALIGNMENT,Size ) )
+    if ( posix_memalign ( &pResult,MEMORY_ALIGNMENT,Size ) )
         return 0;
     else
         return ( unsigned char* ) pResult;
@@ -46,228 +46,159 @@ void AlignedFree ( void* ptr )
 #endif
 };
 
-namespace {
-[[nodiscard]] bool isAligned(unsigned char const* p) noexcept {
-  return reinterpret_cast<uintptr_t>(p) % ARITHMETIC_ALIGNMENT == 0;
-}
-}  // namespace
+const char* pISANames[isaEnd]={"sse2","ssse3","avx2","avx2gfni","avx512bw","avx512gfni"};
 
-/**XOR arrays A and B, storing the result in A
-Depending on alignment of the arrays, different implementations are used*/
-void XOR ( unsigned char* pA,const unsigned char* pB,unsigned Size )
+///@return true if the CPU can execute the kernels for a given instruction set
+bool IsISASupported(eArithmeticISA ISA)
 {
-  assert(Size % ARITHMETIC_ALIGNMENT == 0);
-
-    LOCKEDADD(opXOR,Size);
-#ifdef AVX
-    for ( unsigned i=0;i<Size;i+=32 )
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    switch(ISA)
     {
-        __m256* a= ( __m256* ) ( pA+i );
-        const __m256* b= ( const __m256* ) ( pB+i );
-        *a=_mm256_xor_ps ( *a,*b );
+    case isaSSE2:
+        return __builtin_cpu_supports("sse2");
+    case isaSSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case isaAVX2:
+        return __builtin_cpu_supports("avx2");
+    case isaAVX2GFNI:
+        return __builtin_cpu_supports("avx2")&&__builtin_cpu_supports("gfni");
+    case isaAVX512BW:
+        return __builtin_cpu_supports("avx512f")&&__builtin_cpu_supports("avx512bw");
+    case isaAVX512GFNI:
+        return __builtin_cpu_supports("avx512f")&&__builtin_cpu_supports("avx512bw")&&__builtin_cpu_supports("gfni");
+    default:
+        return false;
     };
 #else
-    if ( size_t ( pB ) &0xF )
-    {
-        //B is not aligned
-        if ( ! ( size_t ( pA ) &0xF ) )
-            //A is aligned
-            for ( unsigned i=0;i<Size;i+=16 )
-            {
-                __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                * ( __m128i* ) ( pA+i ) =_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),B );
-            }
-        else
-            //A is not aligned
-            for ( unsigned i=0;i<Size;i+=16 )
-            {
-                __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                A=_mm_xor_si128 ( A,B );
-                _mm_storeu_si128 ( ( __m128i* ) ( pA+i ),A );
-            }
-    }
-    else
-    {
-        //B is aligned
-        if ( ! ( size_t ( pA ) &0xF ) )
-            //everything is aligned
-            for ( unsigned i=0;i<Size;i+=16 )
-            {
-                * ( __m128i* ) ( pA+i ) =_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),* ( __m128i* ) ( pB+i ) );
-            }
-        else
-            //A is not aligned
-            for ( unsigned i=0;i<Size;i+=16 )
-            {
-                __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                A=_mm_xor_si128 ( A,* ( const __m128i* ) ( pB+i ) );
-                _mm_storeu_si128 ( ( __m128i* ) ( pA+i ),A );
-            }
-    };
-
+    return ISA==isaSSE2;
 #endif
 };
 
-/**XOR arrays A and B, storing the result in C
-Depending on alignment of the arrays, different implementations are used*/
-void XOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,unsigned Size )
+///the kernel tables for each instruction set
+static const ArithmeticKernels* const pISAKernels[isaEnd]={&KernelsSSE2,&KernelsSSSE3,&KernelsAVX2,&KernelsAVX2GFNI,
+                                                          &KernelsAVX512BW,&KernelsAVX512GFNI};
+static eArithmeticISA CurrentISA=isaSSE2;
+const ArithmeticKernels* pKernels=&KernelsSSE2;
+
+///use the kernels for a given instruction set
+///@return false if it is not supported by the CPU
+bool SelectArithmeticISA(eArithmeticISA ISA)
 {
-  assert(Size % ARITHMETIC_ALIGNMENT == 0);
+    if ((ISA>=isaEnd)||!IsISASupported(ISA))
+        return false;
+    CurrentISA=ISA;
+    pKernels=pISAKernels[ISA];
+    return true;
+};
 
-    LOCKEDADD(opXOR,Size);
-#ifdef AVX
-    for ( unsigned i=0;i<Size;i+=32 )
-    {
-        __m256* a= ( __m256* ) ( pA+i );
-        const __m256* b= ( const __m256* ) ( pB+i );
-        *a=_mm256_xor_ps ( *a,*b );
-    };
-#else
-    if ( size_t ( pB ) &0xF )
-    {
-        //B is not aligned
-        if ( ! ( size_t ( pA ) &0xF ) )
-        {
-            //A is aligned
-            if ( ! ( size_t ( pC ) &0xF ) )
-                //C is aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    * ( __m128i* ) ( pC+i ) =_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),B );
-                }
-            else
-                //C is not aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    __m128i C=_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),B );
-                    _mm_storeu_si128 ( ( __m128i* ) ( pC+i ),C );
-                };
-        }
-        else
-            //A is not aligned
-            if ( ! ( size_t ( pC ) &0xF ) )
-            {
-                //C is aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                    * ( __m128i* ) ( pC+i ) =_mm_xor_si128 ( A,B );
-                }
-            }else
-            {
-                //C is not aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                    __m128i C=_mm_xor_si128 ( A,B );
-                    _mm_storeu_si128 ( ( __m128i* ) ( pC+i ),C );
-                }
-            };
-    }
-    else
-    {
-        //B is aligned
-        if ( ! ( size_t ( pA ) &0xF ) )
-        {
-            //A is aligned
-            if ( ! ( size_t ( pC ) &0xF ) )
-            {
-                //everything is aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    * ( __m128i* ) ( pC+i ) =_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),* ( __m128i* ) ( pB+i ) );
-                };
-            }else
-            {
-                //everything but C is aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i C=_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),* ( __m128i* ) ( pB+i ) );
-                    _mm_storeu_si128 ( ( __m128i* ) ( pC+i ),C );
-                };
-            };
-        }
-        else
-        {
-            //A is not aligned
-            if ( ! ( size_t ( pC ) &0xF ) )
-            {
-                //C is aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                    * ( __m128i* ) ( pC+i ) =_mm_xor_si128 ( A,* ( const __m128i* ) ( pB+i ) );
-                }
-            }else
-            {
-                //C is not aligned
-                for ( unsigned i=0;i<Size;i+=16 )
-                {
-                    __m128i B= _mm_lddqu_si128 ( ( const __m128i* ) ( pB+i ) );
-                    __m128i A= _mm_loadu_si128 ( ( __m128i* ) ( pA+i ) );
-                    __m128i C=_mm_xor_si128 ( A,B );
-                    _mm_storeu_si128 ( ( __m128i* ) ( pC+i ),C );
-                }
-            };
-        };
-    };
+///use the kernels for a given instruction set specified by name
+///@return false if the name is unknown or the instruction set is not supported by the CPU
+bool SelectArithmeticISA(const char* pName)
+{
+    for(unsigned i=0;i<isaEnd;i++)
+        if (strcmp(pName,pISANames[i])==0)
+            return SelectArithmeticISA(eArithmeticISA(i));
+    return false;
+};
 
-#endif
+///@return the instruction set used by the arithmetic kernels
+eArithmeticISA GetArithmeticISA()
+{
+    return CurrentISA;
+};
+
+///select the best kernels supported by the CPU
+static bool SelectBestISA()
+{
+    for(int i=isaEnd-1;i>=0;i--)
+        if (SelectArithmeticISA(eArithmeticISA(i)))
+            return true;
+    return false;
 };
 
+//force kernel selection at program startup
+static bool ISASelected=SelectBestISA();
 
-/**XOR arrays A, B and C, storing the result in D
-Everything must be aligned*/
+/**XOR arrays A and B, storing the result in A*/
+void XOR ( unsigned char* pA,const unsigned char* pB,unsigned Size )
+{
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+
+    COUNTOP(opXOR,Size);
+    pKernels->XOR(pA,pB,Size);
+};
+
+/**XOR arrays A and B, storing the result in C*/
+void XOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,unsigned Size )
+{
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+
+    COUNTOP(opXOR,Size);
+    pKernels->XOR3(pA,pB,pC,Size);
+};
+
+
+/**XOR arrays A, B and C, storing the result in D*/
 void XOR (const unsigned char* pA,const unsigned char* pB,const unsigned char* pC,unsigned char* pD,unsigned Size )
 {
-  assert(Size % ARITHMETIC_ALIGNMENT == 0);
-  assert(isAligned(pA));
-  assert(isAligned(pB));
-  assert(isAligned(pC));
-  assert(isAligned(pD));
-
-    LOCKEDADD(opXOR,2*Size);
-     for ( unsigned i=0;i<Size;i+=16 )
-     {
-         __m128i U=_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),* ( __m128i* ) ( pB+i ) );
-           * ( __m128i* ) ( pD+i ) =_mm_xor_si128 (U,* ( __m128i* ) ( pC+i ));
-      };
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+
+    COUNTOP(opXOR,2*Size);
+    pKernels->XOR4(pA,pB,pC,pD,Size);
 };
 
 
 
-/**XOR arrays A and B, and XOR the result to  C
-Everything must be aligned*/
+/**XOR arrays A and B, and XOR the result to  C*/
 void XORXOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,unsigned Size )
 {
-  assert(Size % ARITHMETIC_ALIGNMENT == 0);
-  assert(isAligned(pA));
-  assert(isAligned(pB));
-  assert(isAligned(pC));
-
-    LOCKEDADD(opXOR,2*Size);
-#ifdef AVX
-    for ( unsigned i=0;i<Size;i+=32 )
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+
+    COUNTOP(opXOR,2*Size);
+    pKernels->XORXOR(pA,pB,pC,Size);
+};
+
+/**XOR n arrays, storing the result in Dest*/
+void XORN(unsigned char* pDest,const unsigned char* const* ppSrc,unsigned n,unsigned Size)
+{
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+    if (n==0)
     {
-        __m256* a= ( __m256* ) ( pA+i );
-        const __m256* b= ( const __m256* ) ( pB+i );
-        *a=_mm256_xor_ps ( *a,*b );
+        memset(pDest,0,Size);
+        return;
     };
-#else
-     for ( unsigned i=0;i<Size;i+=16 )
-     {
-         __m128i Temp=_mm_xor_si128 ( * ( __m128i* ) ( pA+i ),* ( __m128i* ) ( pB+i ) );
-         * ( __m128i* ) ( pC+i ) =_mm_xor_si128 ( * ( __m128i* ) ( pC+i ),Temp);
-     };
+    COUNTOP(opXOR,(n-1)*Size);
+    pKernels->XORN(pDest,ppSrc,n,Size);
+};
 
-#endif
+/**Add an array to n destination arrays*/
+void XORScatter(const unsigned char* pSrc,unsigned char* const* ppDest,unsigned n,unsigned Size)
+{
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+    COUNTOP(opXOR,n*Size);
+    pKernels->XORScatter(pSrc,ppDest,n,Size);
+};
+
+/**Check if the sum of n arrays is zero. The comparisons are not counted as operations*/
+bool IsXORZero(const unsigned char* const* ppSrc,unsigned n,size_t Size)
+{
+    if (n==0)
+        return true;
+    return pKernels->IsXORZero(ppSrc,n,Size);
+};
+
+/**Check if all entries of an array are zero*/
+bool IsZero(const unsigned char* pA,size_t Size)
+{
+    return pKernels->IsXORZero(&pA,1,Size);
+};
+
+/**Check if two arrays are equal*/
+bool Equal(const unsigned char* pA,const unsigned char* pB,size_t Size)
+{
+    const unsigned char* ppSrc[2]={pA,pB};
+    return pKernels->IsXORZero(ppSrc,2,Size);
 };
 
 
@@ -278,6 +209,7 @@ void XORXOR (const unsigned char* pA,const unsigned char* pB,unsigned char* pC,u
 unsigned* GF=0;
 int* LogTable=0;
 MultiplyHelper* pHelper=0;
+unsigned long long* pAffine=0;
 int FieldSize_1=0;
 unsigned Extension=0;
 
@@ -302,6 +234,58 @@ GFValue singleMult(GFValue v1,GFValue v2,unsigned w)
     return GF[c+1];
 }
 
+GFValue singleInverse(GFValue v)
+{
+    assert(v);
+    return GF[1+(FieldSize_1-LogTable[v])%FieldSize_1];
+}
+
+bool InvertGFMatrix(const GFValue* pMatrix,GFValue* pInverse,unsigned Size)
+{
+    GFValue* pA=new GFValue[Size*Size];
+    memcpy(pA,pMatrix,Size*Size);
+    memset(pInverse,0,Size*Size);
+    for(unsigned i=0;i<Size;i++)
+        pInverse[i*Size+i]=1;
+    for(unsigned c=0;c<Size;c++)
+    {
+        unsigned Pivot=c;
+        while (Pivot<Size&&!pA[Pivot*Size+c])
+            Pivot++;
+        if (Pivot==Size)
+        {
+            delete[]pA;
+            return false;
+        };
+        if (Pivot!=c)
+            for(unsigned j=0;j<Size;j++)
+            {
+                swap(pA[c*Size+j],pA[Pivot*Size+j]);
+                swap(pInverse[c*Size+j],pInverse[Pivot*Size+j]);
+            };
+        GFValue D=singleInverse(pA[c*Size+c]);
+        for(unsigned j=0;j<Size;j++)
+        {
+            pA[c*Size+j]=singleMult(pA[c*Size+j],D,Extension);
+            pInverse[c*Size+j]=singleMult(pInverse[c*Size+j],D,Extension);
+        };
+        //eliminate column c from the other rows
+        for(unsigned i=0;i<Size;i++)
+        {
+            GFValue F=pA[i*Size+c];
+            if (i==c||!F)
+                continue;
+            for(unsigned j=0;j<Size;j++)
+            {
+                pA[i*Size+j]^=singleMult(F,pA[c*Size+j],Extension);
+                pInverse[i*Size+j]^=singleMult(F,pInverse[c*Size+j],Extension);
+            };
+        };
+    };
+    delete[]pA;
+    return true;
+}
+
 ///construct GF(2^m) tables. The primitive polynomial is taken from a table
 ///@return false if m is too large
 void InitGF(unsigned m)
@@ -352,11 +336,24 @@ void InitGF(unsigned m)
                 H.LookupHigh[y]=GF[1+L];
             };	
         };
+        //construct affine transformation matrices for each \alpha^x
+        //the j-th column of the matrix is \alpha^{x+j}
+        pAffine=new unsigned long long[FieldSize_1];
+        for(int x=0;x<FieldSize_1;x++)
+        {
+            unsigned long long A=0;
+            for(unsigned j=0;j<m;j++)
+            {
+                unsigned Column=GF[1+x+j];
+                for(unsigned i=0;i<8;i++)
+                    if ((Column>>i)&1)
+                        A|=1ull<<(8*(7-i)+j);
+            };
+            pAffine[x]=A;
+        };
     }
 };
 
-volatile unsigned long long MultiplyCount=0;
-
 const __m128i Mask0F=_mm_set1_epi8(0x0F);
 const __m128i * pMask0F=&Mask0F;
 /**
@@ -375,90 +372,10 @@ void Multiply(int x,///scale factor
     if (x<0)
         //nothing to do
         return;
-    const MultiplyHelper& H=pHelper[x];
-    unsigned PackedCount=Size*sizeof(GFValue)/sizeof(__m128i);
-    const __m128i* pmSrc=(const __m128i*)pSrc;
-    __m128i* pmDest=(__m128i*)pDest;
-
-    LOCKEDADD(opGFMul,Size);
-
-    if ( size_t ( pSrc) &0xF )
-    {
-        //source data is not aligned
-        if ( size_t ( pDest) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //load the source  value
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //write it back
-                _mm_storeu_si128(pmDest+i ,A0);
-            }
-        else
-            //destination is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                pmDest[i]=_mm_xor_si128(A0,A1);
-            };
-    }else
-    {
-        //source data is aligned
-        if ( size_t ( pDest) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //extract the first half byte of source
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte of source
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //write it back
-                _mm_storeu_si128(pmDest+i ,A0);
-            }
-        else
-            //everything is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                pmDest[i]=_mm_xor_si128(A0,A1);
-            };
-    };
+    COUNTOP(opGFMul,Size);
+    pKernels->Multiply(x,pSrc,pDest,Size);
 };
 
-volatile unsigned long long MultiplyAddCount=0;
 /**
 Multiply each value in pSrc by \alpha^x and add the result to pDest.
 The implementation is based on the identity (y0+\alpha^4*y1)*x=y0*x+(\alpha^4*y1)*x,
@@ -481,100 +398,8 @@ void MultiplyAdd(int x,///scale factor
         XOR(pDest,pSrc,Size);
         return;
     };
-
-    const MultiplyHelper& H=pHelper[x];
-    unsigned PackedCount=Size*sizeof(GFValue)/sizeof(__m128i);
-    const __m128i* pmSrc=(const __m128i*)pSrc;
-    __m128i* pmDest=(__m128i*)pDest;
-
-    LOCKEDADD(opGFMulAdd,Size);
-
-    if ( size_t ( pSrc) &0xF )
-    {
-        //source data is not aligned
-        if ( size_t ( pDest) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //load the source  value
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //load the destination value
-                __m128i B= _mm_lddqu_si128 ( pmDest+i );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                B=_mm_xor_si128(B,A0);
-                //write it back
-                _mm_storeu_si128(pmDest+i ,B);
-            }
-        else
-            //destination is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                pmDest[i]=_mm_xor_si128(pmDest[i],A0);
-            };
-    }else
-    {
-        //source data is aligned
-        if ( size_t ( pDest) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //load the destination value
-                __m128i B= _mm_lddqu_si128 ( pmDest+i );
-                //extract the first half byte of source
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte of source
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                B=_mm_xor_si128(B,A0);
-                //write it back
-                _mm_storeu_si128(pmDest+i ,B);
-            }
-        else
-            //everything is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                pmDest[i]=_mm_xor_si128(pmDest[i],A0);
-            };
-    };
+    COUNTOP(opGFMulAdd,Size);
+    pKernels->MultiplyAdd(x,pSrc,pDest,Size);
 };
 
 
@@ -596,99 +421,8 @@ void AddMultiply(int x,///scale factor
     if (x<0)
         //nothing to do
         return;
-    const MultiplyHelper& H=pHelper[x];
-    unsigned PackedCount=Size*sizeof(GFValue)/sizeof(__m128i);
-    __m128i* pmSrc=(__m128i*)pSrc;
-    const __m128i* pmCorrection=(const __m128i*)pCorrection;
-
-    LOCKEDADD(opGFMulAdd,Size);
-
-    if ( size_t ( pSrc) &0xF )
-    {
-        //source data is not aligned
-        if ( size_t ( pCorrection) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //load the source  value
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //load the destination value
-                __m128i B= _mm_lddqu_si128 ( pmCorrection+i );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                B=_mm_xor_si128(B,A0);
-                //write it back
-                _mm_storeu_si128(pmSrc+i ,B);
-            }
-        else
-            //destination is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                __m128i A= _mm_lddqu_si128 ( pmSrc+i  );
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(A,Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(A,4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                pmSrc[i]=_mm_xor_si128(pmCorrection[i],A0);
-            };
-    }else
-    {
-        //source data is aligned
-        if ( size_t ( pCorrection) &0xF )
-            //destination is not aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //load the destination value
-                __m128i B= _mm_lddqu_si128 ( pmCorrection+i );
-                //extract the first half byte of source
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte of source
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                B=_mm_xor_si128(B,A0);
-                //write it back
-                _mm_storeu_si128(pmSrc+i ,B);
-            }
-        else
-            //everything is aligned
-            for(unsigned i=0;i<PackedCount;i++)
-            {
-                //extract the first half byte
-                __m128i A0=_mm_and_si128(pmSrc[i],Mask0F);
-                //extract the second half byte
-                __m128i A1=_mm_srli_epi16(pmSrc[i],4);
-                A1=_mm_and_si128(A1,Mask0F);
-                //compute the product of half-bytes by x
-                A0=_mm_shuffle_epi8(H.Lookup0,A0);
-                A1=_mm_shuffle_epi8(H.Lookup1,A1);
-                //add them up
-                A0=_mm_xor_si128(A0,A1);
-                //add them to the destination
-                pmSrc[i]=_mm_xor_si128(pmCorrection[i],A0);
-            };
-    };
+    COUNTOP(opGFMulAdd,Size);
+    pKernels->AddMultiply(x,pSrc,pCorrection,Size);
 };
 
 
@@ -704,7 +438,7 @@ The products y0*x, \alpha^4*y1*x are stored in helper tables
 void MultiplySum(int x,///scale factor
     const GFValue* pSrc1,///source data block 1
     const GFValue* pSrc2,///source data block 1
-    GFValue* pDest,///destination array. Must be aligned
+    GFValue* pDest,///destination array
     unsigned Size///block size
     )
 {
@@ -714,32 +448,37 @@ void MultiplySum(int x,///scale factor
         //nothing to do
         return;
     };
-    const MultiplyHelper& H=pHelper[x];
-    unsigned PackedCount=Size*sizeof(GFValue)/sizeof(__m128i);
-    __m128i* pmSrc1=(__m128i*)pSrc1;
-    __m128i* pmSrc2=(__m128i*)pSrc2;
-    __m128i* pmDest=(__m128i*)pDest;
-
-    LOCKEDADD(opGFMulAdd,Size);
+    COUNTOP(opGFMulAdd,Size);
+    pKernels->MultiplySum(x,pSrc1,pSrc2,pDest,Size);
+};
 
-    for(unsigned i=0;i<PackedCount;i++)
+/** compute r linear combinations of k data blocks
+ppDest[j][i]=\sum_{l=0}^{k-1} ppSrc[l][i]*\alpha^{pCoefficients[j*k+l]}
+Each input block is fetched only once for every DotProductOutputs outputs, and the outputs are written only once
+*/
+void DotProduct(const GFValue* const* ppSrc,///the input blocks
+                unsigned k,///the number of input blocks
+                const int* pCoefficients,///r x k matrix of scale factors (logarithms). Negative values stand for zero
+                GFValue* const* ppDest,///the output blocks
+                unsigned r,///the number of output blocks
+                unsigned Size///block size
+                )
+{
+    assert(Size % ARITHMETIC_ALIGNMENT == 0);
+#ifdef OPERATION_COUNTING
+    if (OpCountingEnabled)
     {
-          //load the source  value
-          __m128i A= _mm_lddqu_si128 ( pmSrc1+i  );
-          __m128i B= _mm_lddqu_si128 ( pmSrc2+i  );
-          A=_mm_xor_si128(A,B);
-          //extract the first half byte
-          __m128i A0=_mm_and_si128(A,Mask0F);
-           //extract the second half byte
-           __m128i A1=_mm_srli_epi16(A,4);
-           A1=_mm_and_si128(A1,Mask0F);
-           //compute the product of half-bytes by x
-           A0=_mm_shuffle_epi8(H.Lookup0,A0);
-           A1=_mm_shuffle_epi8(H.Lookup1,A1);
-           //add them up
-           A0=_mm_xor_si128(A0,A1);
-          //write it back
-          _mm_store_si128(pmDest+i ,A0);
+        unsigned long long XORs=0,MulAdds=0;
+        for(unsigned i=0;i<r*k;i++)
+        {
+            if (pCoefficients[i]==0)
+                XORs+=Size;
+            else if (pCoefficients[i]>0)
+                MulAdds+=Size;
+        };
+        CountOperation(opXOR,XORs);
+        CountOperation(opGFMulAdd,MulAdds);
     };
-
+#endif
+    pKernels->DotProduct(ppSrc,k,pCoefficients,ppDest,r,Size);
 };
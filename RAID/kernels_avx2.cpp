@@ -0,0 +1,13 @@
+/*********************************************************
+ * kernels_avx2.cpp  - AVX2 arithmetic kernels (256-bit vpshufb)
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+const ArithmeticKernels KernelsAVX2=MakeKernels<VectorList<AVX2Vector, SSE2Vector, ScalarVector>,
+                                                VectorList<AVX2Vector, SSSE3Vector, ScalarVector>>();
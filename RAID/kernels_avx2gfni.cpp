@@ -0,0 +1,13 @@
+/*********************************************************
+ * kernels_avx2gfni.cpp  - AVX2+GFNI arithmetic kernels (vgf2p8affineqb)
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+const ArithmeticKernels KernelsAVX2GFNI=MakeKernels<VectorList<AVX2Vector, SSE2Vector, ScalarVector>,
+                                                  VectorList<AVX2GFNIVector, SSEGFNIVector, ScalarVector>>();
@@ -0,0 +1,13 @@
+/*********************************************************
+ * kernels_avx512.cpp  - AVX-512BW arithmetic kernels (512-bit vpshufb)
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+const ArithmeticKernels KernelsAVX512BW=MakeKernels<VectorList<AVX512BWVector, AVX2Vector, SSE2Vector, ScalarVector>,
+                                                    VectorList<AVX512BWVector, AVX2Vector, SSSE3Vector, ScalarVector>>();
@@ -0,0 +1,13 @@
+/*********************************************************
+ * kernels_avx512gfni.cpp  - AVX-512BW+GFNI arithmetic kernels (512-bit vgf2p8affineqb)
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+const ArithmeticKernels KernelsAVX512GFNI=MakeKernels<VectorList<AVX512BWVector, AVX2Vector, SSE2Vector, ScalarVector>,
+                                                    VectorList<AVX512GFNIVector, AVX2GFNIVector, SSEGFNIVector, ScalarVector>>();
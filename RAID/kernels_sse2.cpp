@@ -0,0 +1,14 @@
+/*********************************************************
+ * kernels_sse2.cpp  - SSE2 arithmetic kernels
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+//there is no byte shuffle in SSE2, so GF(2^m) multiplication is done by table lookups
+const ArithmeticKernels KernelsSSE2=MakeKernels<VectorList<SSE2Vector, ScalarVector>,
+                                                VectorList<ScalarVector>>();
@@ -0,0 +1,13 @@
+/*********************************************************
+ * kernels_ssse3.cpp  - SSSE3 arithmetic kernels (128-bit pshufb)
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include "kerneltemplates.h"
+
+const ArithmeticKernels KernelsSSSE3=MakeKernels<VectorList<SSE2Vector, ScalarVector>,
+                                                 VectorList<SSSE3Vector, ScalarVector>>();
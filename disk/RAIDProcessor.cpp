@@ -207,6 +207,118 @@ bool CRAIDProcessor::ReadData ( unsigned long long StripeID,///the stripe to be
     return Result;
 };
 
+/** Units of non-erased symbols are read directly. If some of them reside on erased symbols,
+ * the decoder is assumed to read all surviving symbols
+ */
+unsigned CRAIDProcessor::GetReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                     unsigned StripeUnitID,///the first stripe unit to be read
+                                     unsigned NumOfUnits,///the number of units to be read
+                                     size_t ThreadID ///the ID of the calling thread
+                                    )
+{
+    if (!NumOfUnits)
+        return 0;
+    unsigned FirstSymbolID=StripeUnitID/m_StripeUnitsPerSymbol;
+    unsigned LastSymbolID=(StripeUnitID+NumOfUnits-1)/m_StripeUnitsPerSymbol;
+    for (unsigned i=FirstSymbolID;i<=LastSymbolID;i++)
+    {
+        if (IsErased(ErasureSetID,i))
+            return (m_Length-GetNumOfErasures(ErasureSetID))*m_StripeUnitsPerSymbol;
+    };
+    return NumOfUnits;
+};
+
+/** The recovery sources within the requested range are fetched anyway, so they are counted once
+ */
+unsigned CRAIDProcessor::GetRecoveryReadCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                             unsigned SymbolID,///the first requested symbol
+                                             unsigned NumOfSymbols,///the number of requested symbols
+                                             const unsigned* pSources,///the surviving symbols used for recovery
+                                             unsigned NumOfSources///the number of recovery sources
+                                            )const
+{
+    unsigned Cost=0;
+    bool NeedsDecoding=false;
+    for(unsigned i=SymbolID;i<SymbolID+NumOfSymbols;i++)
+    {
+        if (IsErased(ErasureSetID,i))
+            NeedsDecoding=true;
+        else
+            Cost++;
+    };
+    if (NeedsDecoding)
+    {
+        for(unsigned j=0;j<NumOfSources;j++)
+            if (pSources[j]<SymbolID||pSources[j]>=SymbolID+NumOfSymbols)
+                Cost++;
+    };
+    return Cost;
+};
+
+/** The old values of the data units are read, and each non-erased check symbol is updated
+ * at up to m_StripeUnitsPerSymbol positions
+ */
+bool CRAIDProcessor::GetUpdateCost(unsigned ErasureSetID,///identifies the load balancing offset
+                                   unsigned StripeUnitID,///the first stripe unit to be updated
+                                   unsigned Units2Update,///the number of units to be updated
+                                   IOCost& Cost,///receives the cost
+                                   size_t ThreadID ///the ID of the calling thread
+                                  )
+{
+    unsigned FirstSymbolID=StripeUnitID/m_StripeUnitsPerSymbol;
+    unsigned LastSymbolID=(StripeUnitID+Units2Update-1)/m_StripeUnitsPerSymbol;
+    for (unsigned i=FirstSymbolID;i<=LastSymbolID;i++)
+    {
+        if (IsErased(ErasureSetID,i))
+            return false;
+    };
+    unsigned CheckUnits=0;
+    for (unsigned i=m_Dimension;i<m_Length;i++)
+    {
+        if (!IsErased(ErasureSetID,i))
+            CheckUnits+=min(Units2Update,m_StripeUnitsPerSymbol);
+    };
+    //the old data is not needed if there is nothing to update
+    Cost.Reads=(CheckUnits)?Units2Update+CheckUnits:0;
+    Cost.Writes=Units2Update+CheckUnits;
+    return true;
+};
+
+/** The data residing before and after the new data is fetched via ReadData,
+ * and all non-erased symbols are written
+ */
+CRAIDProcessor::IOCost CRAIDProcessor::GetReconstructWriteCost(unsigned ErasureSetID,///identifies the load balancing offset
+        unsigned StripeUnitID,///the first stripe unit to be updated
+        unsigned Subsymbols2Encode,///the number of subsymbols to be encoded
+        size_t ThreadID ///the ID of the calling thread
+                                                              )
+{
+    unsigned TotalUnits=m_Dimension*m_StripeUnitsPerSymbol;
+    IOCost Cost;
+    Cost.Reads=GetReadCost(ErasureSetID,0,StripeUnitID,ThreadID)+
+               GetReadCost(ErasureSetID,StripeUnitID+Subsymbols2Encode,TotalUnits-(StripeUnitID+Subsymbols2Encode),ThreadID);
+    Cost.Writes=(m_Length-GetNumOfErasures(ErasureSetID))*m_StripeUnitsPerSymbol;
+    return Cost;
+};
+
+/** Compare the number of stripe units transferred by read-modify-write and reconstruct-write.
+ * Read-modify-write is preferred in case of a tie, since it involves less computations
+ */
+CRAIDProcessor::eEncodingStrategy CRAIDProcessor::GetEncodingStrategy(unsigned ErasureSetID,///identifies the load balancing offset
+        unsigned StripeUnitID,///the first stripe unit to be updated
+        unsigned Subsymbols2Encode,///the number of subsymbols to be encoded
+        size_t ThreadID ///the ID of the calling thread
+                                                                     )
+{
+    if (Subsymbols2Encode==m_Dimension*m_StripeUnitsPerSymbol)
+        return esFullStripe;
+    IOCost Update;
+    if (!GetUpdateCost(ErasureSetID,StripeUnitID,Subsymbols2Encode,Update,ThreadID))
+        return esReconstructWrite;
+    IOCost Reconstruct=GetReconstructWriteCost(ErasureSetID,StripeUnitID,Subsymbols2Encode,ThreadID);
+    return (Update.Total()<=Reconstruct.Total())?esReadModifyWrite:esReconstructWrite;
+};
+
 /**Translate write call into a number of Encode calls
  * The encoding strategy is determined by the GetEncodingStrategy function. If needed,
  * this method will get all non-affected the data from the disk and re-encode it
@@ -221,35 +333,31 @@ bool CRAIDProcessor::WriteData ( unsigned long long StripeID,///the stripe to be
 {
     unsigned ErasureSetID=(StripeID%m_Length)+SubarrayID*m_Length;
     bool Result=true;
-    if ( GetEncodingStrategy (ErasureSetID,StripeUnitID,NumOfUnits ) )
+    switch ( GetEncodingStrategy ( ErasureSetID,StripeUnitID,NumOfUnits,ThreadID ) )
     {
-		if ( NumOfUnits==m_Dimension*m_StripeUnitsPerSymbol )
-            Result&=EncodeStripe ( StripeID,ErasureSetID,pSrc,ThreadID );
-        else
+    case esFullStripe:
+        return EncodeStripe ( StripeID,ErasureSetID,pSrc,ThreadID );
+    case esReconstructWrite:
+    {
+        unsigned char* pBuffer=m_pUpdateBuffer+ThreadID*m_Dimension*m_StripeUnitsPerSymbol*m_StripeUnitSize;
+        if ( StripeUnitID )
         {
-            unsigned char* pBuffer=m_pUpdateBuffer+ThreadID*m_Dimension*m_StripeUnitsPerSymbol*m_StripeUnitSize;
-            if ( StripeUnitID )
-            {
-                //fetch the data residing before the new data
-                Result&=ReadData ( StripeID,0,SubarrayID,StripeUnitID,pBuffer,ThreadID );
-            };
-            memcpy ( pBuffer+StripeUnitID*m_StripeUnitSize,pSrc,NumOfUnits*m_StripeUnitSize );
-            int TrailingUnits=m_Dimension*m_StripeUnitsPerSymbol- ( StripeUnitID+NumOfUnits );
-            if ( TrailingUnits>0 )
-            {
-                //fetch the data residing after the new data
-                Result&=ReadData ( StripeID,StripeUnitID+NumOfUnits,SubarrayID,TrailingUnits,pBuffer+ ( StripeUnitID+NumOfUnits ) *m_StripeUnitSize,ThreadID );
-            };
-            Result&=EncodeStripe ( StripeID,ErasureSetID,pBuffer,ThreadID );
+            //fetch the data residing before the new data
+            Result&=ReadData ( StripeID,0,SubarrayID,StripeUnitID,pBuffer,ThreadID );
+        };
+        memcpy ( pBuffer+StripeUnitID*m_StripeUnitSize,pSrc,NumOfUnits*m_StripeUnitSize );
+        int TrailingUnits=m_Dimension*m_StripeUnitsPerSymbol- ( StripeUnitID+NumOfUnits );
+        if ( TrailingUnits>0 )
+        {
+            //fetch the data residing after the new data
+            Result&=ReadData ( StripeID,StripeUnitID+NumOfUnits,SubarrayID,TrailingUnits,pBuffer+ ( StripeUnitID+NumOfUnits ) *m_StripeUnitSize,ThreadID );
         };
+        Result&=EncodeStripe ( StripeID,ErasureSetID,pBuffer,ThreadID );
         return Result;
     }
-    else
-    {
+    default:
         //update selected symbols
-        bool Res=UpdateInformationSymbols ( StripeID,ErasureSetID,StripeUnitID,NumOfUnits,pSrc,ThreadID );
-	return Res;
-
+        return UpdateInformationSymbols ( StripeID,ErasureSetID,StripeUnitID,NumOfUnits,pSrc,ThreadID );
     };
 }
 
@@ -472,7 +472,7 @@ bool CDisk::ReadData(unsigned long long BlockID, ///the first block to be read
         return false;
     if (BlockID + NumOfBlocks > m_NumOfBlocks) //invalid read request
         return false;
-	LOCKEDADD(opRead,NumOfBlocks*m_BlockSize);
+	COUNTOP(opRead,NumOfBlocks*m_BlockSize);
 #ifdef USE_MMAP
     memcpy(pDest,m_pMap+m_PayloadOffset + BlockID*m_BlockSize,NumOfBlocks*m_BlockSize);
     return true;
@@ -519,7 +519,7 @@ bool CDisk::WriteData(unsigned long long BlockID, ///start of the destination ar
         return false;
     if (BlockID + NumOfBlocks > m_NumOfBlocks) //invalid write request
         return false;
-	LOCKEDADD(opWrite,NumOfBlocks*m_BlockSize);
+	COUNTOP(opWrite,NumOfBlocks*m_BlockSize);
 #ifdef USE_MMAP
     memcpy(m_pMap+m_PayloadOffset + BlockID*m_BlockSize,pData,NumOfBlocks*m_BlockSize);
     return true;
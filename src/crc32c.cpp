@@ -0,0 +1,126 @@
+/*********************************************************
+ * crc32c.cpp  - CRC32C (Castagnoli) checksum with runtime implementation selection
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include <string.h>
+#include "misc.h"
+
+///reflected CRC32C polynomial
+#define POLY_32C 0x82F63B78u
+
+///implemented in crc32c_sse42.cpp
+unsigned CRC32CSSE42(unsigned CRC,const unsigned char* pBuf,size_t Size);
+
+///tables for slicing-by-8 CRC computation. CRC32CTable[k][n] is the CRC of byte n followed by k zero bytes
+static unsigned CRC32CTable[8][256];
+
+static bool InitCRC32CTables()
+{
+    for(unsigned n=0;n<256;n++)
+    {
+        unsigned CRC=n;
+        for(unsigned j=0;j<8;j++)
+            CRC=(CRC&1)?(CRC>>1)^POLY_32C:CRC>>1;
+        CRC32CTable[0][n]=CRC;
+    };
+    for(unsigned n=0;n<256;n++)
+        for(unsigned k=1;k<8;k++)
+            CRC32CTable[k][n]=(CRC32CTable[k-1][n]>>8)^CRC32CTable[0][CRC32CTable[k-1][n]&0xFF];
+    return true;
+};
+
+//force table construction at program startup
+static bool CRC32CTablesReady=InitCRC32CTables();
+
+///portable slicing-by-8 implementation. The CRC is passed and returned in inverted form
+static unsigned CRC32CSlicing8(unsigned CRC,const unsigned char* pBuf,size_t Size)
+{
+    //process the bytes up to the first 8-byte boundary
+    while(Size&&(((size_t)pBuf)&7))
+    {
+        CRC=CRC32CTable[0][(CRC^*pBuf++)&0xFF]^(CRC>>8);
+        Size--;
+    };
+    while(Size>=8)
+    {
+        unsigned long long W;
+        memcpy(&W,pBuf,sizeof(W));
+        W^=CRC;
+        CRC=CRC32CTable[7][W&0xFF]^CRC32CTable[6][(W>>8)&0xFF]^
+            CRC32CTable[5][(W>>16)&0xFF]^CRC32CTable[4][(W>>24)&0xFF]^
+            CRC32CTable[3][(W>>32)&0xFF]^CRC32CTable[2][(W>>40)&0xFF]^
+            CRC32CTable[1][(W>>48)&0xFF]^CRC32CTable[0][W>>56];
+        pBuf+=8;
+        Size-=8;
+    };
+    while(Size--)
+        CRC=CRC32CTable[0][(CRC^*pBuf++)&0xFF]^(CRC>>8);
+    return CRC;
+};
+
+typedef unsigned (*CRC32CFunction)(unsigned CRC,const unsigned char* pBuf,size_t Size);
+
+const char* pCRC32CNames[crcEnd]={"slicing8","sse4.2"};
+static const CRC32CFunction pCRC32CFunctions[crcEnd]={CRC32CSlicing8,CRC32CSSE42};
+static eCRC32CImplementation CurrentCRC32C=crcSlicing8;
+
+bool IsCRC32CSupported(eCRC32CImplementation Implementation)
+{
+    switch(Implementation)
+    {
+    case crcSlicing8:
+        return true;
+    case crcSSE42:
+#ifdef __GNUC__
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+#else
+        return false;
+#endif
+    default:
+        return false;
+    };
+};
+
+bool SelectCRC32C(eCRC32CImplementation Implementation)
+{
+    if ((Implementation>=crcEnd)||!IsCRC32CSupported(Implementation))
+        return false;
+    CurrentCRC32C=Implementation;
+    return true;
+};
+
+bool SelectCRC32C(const char* pName)
+{
+    for(unsigned i=0;i<crcEnd;i++)
+        if (!strcmp(pName,pCRC32CNames[i]))
+            return SelectCRC32C(eCRC32CImplementation(i));
+    return false;
+};
+
+eCRC32CImplementation GetCRC32C()
+{
+    return CurrentCRC32C;
+};
+
+///select the fastest implementation supported by the CPU
+static bool SelectBestCRC32C()
+{
+    for(int i=crcEnd-1;i>=0;i--)
+        if (SelectCRC32C(eCRC32CImplementation(i)))
+            return true;
+    return false;
+};
+
+//force implementation selection at program startup
+static bool CRC32CSelected=SelectBestCRC32C();
+
+void UpdateCRC32C(unsigned& CRC,size_t Size,const unsigned char* pBuf)
+{
+    CRC=~pCRC32CFunctions[CurrentCRC32C](~CRC,pBuf,Size);
+};
@@ -0,0 +1,158 @@
+/*********************************************************
+ * crc32c_sse42.cpp  - CRC32C computation using SSE4.2 crc32 instruction
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include <string.h>
+#include <nmmintrin.h>
+
+///reflected CRC32C polynomial
+#define POLY_32C 0x82F63B78u
+///block sizes for 3-way interleaved processing. They must be powers of 2
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+/* crc32 instruction has latency 3 and throughput 1, so three independent streams are processed
+at once. Their CRCs are combined by multiplying the CRC of the first stream by x^{8*Length},
+which is done via lookup tables
+*/
+
+///multiply a vector by a 32x32 matrix over GF(2)
+static unsigned MatrixTimes(const unsigned* pMatrix,unsigned Vector)
+{
+    unsigned Sum=0;
+    while(Vector)
+    {
+        if (Vector&1)
+            Sum^=*pMatrix;
+        Vector>>=1;
+        pMatrix++;
+    };
+    return Sum;
+};
+
+static void MatrixSquare(unsigned* pSquare,const unsigned* pMatrix)
+{
+    for(unsigned n=0;n<32;n++)
+        pSquare[n]=MatrixTimes(pMatrix,pMatrix[n]);
+};
+
+///construct the operator which appends Length zero bytes to the data. Length must be a power of 2
+static void ZerosOperator(unsigned* pEven,size_t Length)
+{
+    unsigned Odd[32];
+    //the operator for one zero bit
+    Odd[0]=POLY_32C;
+    unsigned Row=1;
+    for(unsigned n=1;n<32;n++)
+    {
+        Odd[n]=Row;
+        Row<<=1;
+    };
+    //two zero bits
+    MatrixSquare(pEven,Odd);
+    //four zero bits
+    MatrixSquare(Odd,pEven);
+    //the first square gives the operator for one zero byte, the next one for two bytes, etc.
+    do
+    {
+        MatrixSquare(pEven,Odd);
+        Length>>=1;
+        if (!Length)
+            return;
+        MatrixSquare(Odd,pEven);
+        Length>>=1;
+    }while(Length);
+    memcpy(pEven,Odd,sizeof(Odd));
+};
+
+///tables for appending CRC32C_LONG and CRC32C_SHORT zero bytes
+static unsigned ZerosLong[4][256];
+static unsigned ZerosShort[4][256];
+
+static void InitZerosTable(unsigned Zeros[4][256],size_t Length)
+{
+    unsigned Op[32];
+    ZerosOperator(Op,Length);
+    for(unsigned n=0;n<256;n++)
+    {
+        Zeros[0][n]=MatrixTimes(Op,n);
+        Zeros[1][n]=MatrixTimes(Op,n<<8);
+        Zeros[2][n]=MatrixTimes(Op,n<<16);
+        Zeros[3][n]=MatrixTimes(Op,n<<24);
+    };
+};
+
+static bool InitZerosTables()
+{
+    InitZerosTable(ZerosLong,CRC32C_LONG);
+    InitZerosTable(ZerosShort,CRC32C_SHORT);
+    return true;
+};
+
+//force table construction at program startup
+static bool ZerosTablesReady=InitZerosTables();
+
+///append zero bytes to the data with a given CRC
+static inline unsigned Shift(const unsigned Zeros[4][256],unsigned CRC)
+{
+    return Zeros[0][CRC&0xFF]^Zeros[1][(CRC>>8)&0xFF]^Zeros[2][(CRC>>16)&0xFF]^Zeros[3][CRC>>24];
+};
+
+static inline unsigned long long Load64(const unsigned char* p)
+{
+    unsigned long long W;
+    memcpy(&W,p,sizeof(W));
+    return W;
+};
+
+///process Length*3 bytes as three interleaved streams
+static inline unsigned CRC32C3Way(unsigned CRC0,const unsigned char*& pBuf,size_t& Size,size_t Length,
+                                  const unsigned Zeros[4][256])
+{
+    while(Size>=3*Length)
+    {
+        unsigned long long C0=CRC0,C1=0,C2=0;
+        const unsigned char* pEnd=pBuf+Length;
+        do
+        {
+            C0=_mm_crc32_u64(C0,Load64(pBuf));
+            C1=_mm_crc32_u64(C1,Load64(pBuf+Length));
+            C2=_mm_crc32_u64(C2,Load64(pBuf+2*Length));
+            pBuf+=8;
+        }while(pBuf<pEnd);
+        CRC0=Shift(Zeros,(unsigned)C0)^(unsigned)C1;
+        CRC0=Shift(Zeros,CRC0)^(unsigned)C2;
+        pBuf+=2*Length;
+        Size-=3*Length;
+    };
+    return CRC0;
+};
+
+///The CRC is passed and returned in inverted form
+unsigned CRC32CSSE42(unsigned CRC,const unsigned char* pBuf,size_t Size)
+{
+    //process the bytes up to the first 8-byte boundary
+    while(Size&&(((size_t)pBuf)&7))
+    {
+        CRC=_mm_crc32_u8(CRC,*pBuf++);
+        Size--;
+    };
+    CRC=CRC32C3Way(CRC,pBuf,Size,CRC32C_LONG,ZerosLong);
+    CRC=CRC32C3Way(CRC,pBuf,Size,CRC32C_SHORT,ZerosShort);
+    unsigned long long C=CRC;
+    while(Size>=8)
+    {
+        C=_mm_crc32_u64(C,Load64(pBuf));
+        pBuf+=8;
+        Size-=8;
+    };
+    CRC=(unsigned)C;
+    while(Size--)
+        CRC=_mm_crc32_u8(CRC,*pBuf++);
+    return CRC;
+};
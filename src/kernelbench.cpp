@@ -0,0 +1,252 @@
+/*********************************************************
+ * kernelbench.cpp  - microbenchmark for the arithmetic kernels
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+#include <iostream>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <x86intrin.h>
+#include "arithmetic.h"
+#include "misc.h"
+
+using namespace std;
+
+//the range of block sizes to be benchmarked. The smallest one is the smallest stripe unit size in RTP.csv
+#define MIN_BLOCK_SIZE 32
+#define MAX_BLOCK_SIZE (8*1024*1024)
+//the maximal number of source blocks
+#define MAX_SOURCES 16
+//the number of outputs of DotProduct
+#define DOT_PRODUCT_OUTPUTS 4
+//the total number of blocks: sources, outputs, the zero block and the copy of the first source
+#define NUM_OF_BUFFERS (MAX_SOURCES+DOT_PRODUCT_OUTPUTS+2)
+//offsets of the blocks with respect to MEMORY_ALIGNMENT
+static const unsigned Offsets[]={0,1,16};
+
+void Usage()
+{
+    cerr << "Usage: kernelbench [ISA [Kernel [MinTime]]]\n"
+        "\tISA: one of the supported instruction sets (see pISANames), or all\n"
+        "\tKernel: XOR, XOR3, XOR4, XORXOR, XORN, XORScatter, Multiply, MultiplyAdd, AddMultiply, MultiplySum, DotProduct,\n"
+        "\t        IsZero, Equal, IsXORZero, or all\n"
+        "\tMinTime: the minimal duration of each measurement in seconds (0.01 by default)\n"
+        "The results are printed in CSV format. Throughput is given with respect to the amount of input data\n";
+};
+
+///the data being processed by the kernels
+struct BenchData
+{
+    unsigned char* ppBuffers[NUM_OF_BUFFERS];
+    const unsigned char* ppSrc[MAX_SOURCES];
+    unsigned char* ppDest[DOT_PRODUCT_OUTPUTS];
+    int Coefficients[DOT_PRODUCT_OUTPUTS*MAX_SOURCES];
+    ///the zero tests exit at the first non-zero word, so they are given data which passes them.
+    ///This is an all-zero block
+    const unsigned char* pZero;
+    ///a copy of ppSrc[0]
+    const unsigned char* pCopy;
+    ///each source block is listed twice, so that their sum is zero
+    const unsigned char* ppPairs[MAX_SOURCES];
+};
+
+///a kernel invocation. The data is taken from BenchData
+typedef void (*BenchKernel)(BenchData& D,unsigned Sources,unsigned Size);
+
+static void BenchXOR(BenchData& D,unsigned,unsigned Size)
+{
+    XOR(D.ppDest[0],D.ppSrc[0],Size);
+};
+static void BenchXOR3(BenchData& D,unsigned,unsigned Size)
+{
+    XOR(D.ppSrc[0],D.ppSrc[1],D.ppDest[0],Size);
+};
+static void BenchXOR4(BenchData& D,unsigned,unsigned Size)
+{
+    XOR(D.ppSrc[0],D.ppSrc[1],D.ppSrc[2],D.ppDest[0],Size);
+};
+static void BenchXORXOR(BenchData& D,unsigned,unsigned Size)
+{
+    XORXOR(D.ppSrc[0],D.ppSrc[1],D.ppDest[0],Size);
+};
+static void BenchXORN(BenchData& D,unsigned Sources,unsigned Size)
+{
+    XORN(D.ppDest[0],D.ppSrc,Sources,Size);
+};
+static void BenchXORScatter(BenchData& D,unsigned Sources,unsigned Size)
+{
+    XORScatter(D.ppSrc[0],D.ppDest,Sources,Size);
+};
+static void BenchMultiply(BenchData& D,unsigned,unsigned Size)
+{
+    Multiply(D.Coefficients[0],D.ppSrc[0],D.ppDest[0],Size);
+};
+static void BenchMultiplyAdd(BenchData& D,unsigned,unsigned Size)
+{
+    MultiplyAdd(D.Coefficients[0],D.ppSrc[0],D.ppDest[0],Size);
+};
+static void BenchAddMultiply(BenchData& D,unsigned,unsigned Size)
+{
+    AddMultiply(D.Coefficients[0],D.ppDest[0],D.ppSrc[0],Size);
+};
+static void BenchMultiplySum(BenchData& D,unsigned,unsigned Size)
+{
+    MultiplySum(D.Coefficients[0],D.ppSrc[0],D.ppSrc[1],D.ppDest[0],Size);
+};
+static void BenchDotProduct(BenchData& D,unsigned Sources,unsigned Size)
+{
+    DotProduct(D.ppSrc,Sources,D.Coefficients,D.ppDest,DOT_PRODUCT_OUTPUTS,Size);
+};
+//the results of the zero tests are stored here, so that the calls are not optimized out
+static volatile bool ZeroTestResult;
+static void BenchIsZero(BenchData& D,unsigned,unsigned Size)
+{
+    ZeroTestResult=IsZero(D.pZero,Size);
+};
+static void BenchEqual(BenchData& D,unsigned,unsigned Size)
+{
+    ZeroTestResult=Equal(D.ppSrc[0],D.pCopy,Size);
+};
+static void BenchIsXORZero(BenchData& D,unsigned Sources,unsigned Size)
+{
+    ZeroTestResult=IsXORZero(D.ppPairs,Sources,Size);
+};
+
+///description of a benchmarked kernel
+struct KernelInfo
+{
+    const char* pName;
+    BenchKernel Kernel;
+    ///the range of source counts to be tried. The count is doubled at each step.
+    ///For XORScatter, this is the number of destinations
+    unsigned MinSources;
+    unsigned MaxSources;
+};
+
+static const KernelInfo Kernels[]={
+    {"XOR",BenchXOR,1,1},
+    {"XOR3",BenchXOR3,2,2},
+    {"XOR4",BenchXOR4,3,3},
+    {"XORXOR",BenchXORXOR,2,2},
+    {"XORN",BenchXORN,2,MAX_SOURCES},
+    {"XORScatter",BenchXORScatter,1,DOT_PRODUCT_OUTPUTS},
+    {"Multiply",BenchMultiply,1,1},
+    {"MultiplyAdd",BenchMultiplyAdd,1,1},
+    {"AddMultiply",BenchAddMultiply,1,1},
+    {"MultiplySum",BenchMultiplySum,2,2},
+    {"DotProduct",BenchDotProduct,2,MAX_SOURCES},
+    {"IsZero",BenchIsZero,1,1},
+    {"Equal",BenchEqual,2,2},
+    {"IsXORZero",BenchIsXORZero,2,MAX_SOURCES}
+};
+
+///run the kernel repeatedly for at least MinTime seconds,
+///and obtain the average time and the number of TSC cycles per invocation
+static void Measure(const KernelInfo& K,BenchData& D,unsigned Sources,unsigned Size,double MinTime,
+                    double& Seconds,double& Cycles)
+{
+    typedef chrono::steady_clock Clock;
+    //warm up the caches
+    K.Kernel(D,Sources,Size);
+    unsigned long long Iterations=0;
+    unsigned long long Batch=1;
+    Clock::time_point Start=Clock::now();
+    unsigned long long StartTSC=__rdtsc();
+    double Elapsed;
+    do
+    {
+        for(unsigned long long i=0;i<Batch;i++)
+            K.Kernel(D,Sources,Size);
+        Iterations+=Batch;
+        Batch*=2;
+        Elapsed=chrono::duration<double>(Clock::now()-Start).count();
+    }while(Elapsed<MinTime);
+    Cycles=double(__rdtsc()-StartTSC)/Iterations;
+    Seconds=Elapsed/Iterations;
+};
+
+int main(int argc,char** argv)
+{
+    const char* pISA=(argc>1)?argv[1]:"all";
+    const char* pKernel=(argc>2)?argv[2]:"all";
+    double MinTime=(argc>3)?atof(argv[3]):0.01;
+    if ((argc>4)||(MinTime<=0))
+    {
+        Usage();
+        return 1;
+    };
+#ifdef OPERATION_COUNTING
+    //do not let counting affect the results
+    EnableOpCounting(false);
+#endif
+    InitGF(8);
+
+    BenchData D;
+    srand(1);
+    for(unsigned i=0;i<NUM_OF_BUFFERS;i++)
+    {
+        D.ppBuffers[i]=AlignedMalloc(MAX_BLOCK_SIZE+MEMORY_ALIGNMENT);
+        for(unsigned j=0;j<MAX_BLOCK_SIZE+MEMORY_ALIGNMENT;j++)
+            D.ppBuffers[i][j]=rand();
+    };
+    unsigned char* pZero=D.ppBuffers[MAX_SOURCES+DOT_PRODUCT_OUTPUTS];
+    unsigned char* pCopy=D.ppBuffers[MAX_SOURCES+DOT_PRODUCT_OUTPUTS+1];
+    memset(pZero,0,MAX_BLOCK_SIZE+MEMORY_ALIGNMENT);
+    memcpy(pCopy,D.ppBuffers[0],MAX_BLOCK_SIZE+MEMORY_ALIGNMENT);
+    for(unsigned i=0;i<DOT_PRODUCT_OUTPUTS*MAX_SOURCES;i++)
+        D.Coefficients[i]=1+rand()%(FieldSize_1-1);
+
+    bool Found=false;
+    cout<<"ISA,Kernel,Sources,Size,Offset,GB/s,Cycles/byte"<<endl;
+    for(unsigned isa=0;isa<isaEnd;isa++)
+    {
+        if (strcmp(pISA,"all")&&strcmp(pISA,pISANames[isa]))
+            continue;
+        if (!SelectArithmeticISA(eArithmeticISA(isa)))
+        {
+            cerr<<"Instruction set "<<pISANames[isa]<<" is not supported by this CPU\n";
+            continue;
+        };
+        for(const KernelInfo& K:Kernels)
+        {
+            if (strcmp(pKernel,"all")&&strcmp(pKernel,K.pName))
+                continue;
+            Found=true;
+            for(unsigned Sources=K.MinSources;Sources<=K.MaxSources;Sources*=2)
+            {
+                for(unsigned Offset:Offsets)
+                {
+                    for(unsigned i=0;i<MAX_SOURCES;i++)
+                        D.ppSrc[i]=D.ppBuffers[i]+Offset;
+                    for(unsigned i=0;i<DOT_PRODUCT_OUTPUTS;i++)
+                        D.ppDest[i]=D.ppBuffers[MAX_SOURCES+i]+Offset;
+                    D.pZero=pZero+Offset;
+                    D.pCopy=pCopy+Offset;
+                    for(unsigned i=0;i<MAX_SOURCES;i++)
+                        D.ppPairs[i]=D.ppBuffers[i/2]+Offset;
+                    for(unsigned Size=MIN_BLOCK_SIZE;Size<=MAX_BLOCK_SIZE;Size*=4)
+                    {
+                        double Seconds,Cycles;
+                        Measure(K,D,Sources,Size,MinTime,Seconds,Cycles);
+                        double Bytes=double(Size)*Sources;
+                        cout<<pISANames[isa]<<','<<K.pName<<','<<Sources<<','<<Size<<','<<Offset<<','
+                            <<Bytes/Seconds*1E-9<<','<<Cycles/Bytes<<endl;
+                    };
+                };
+            };
+        };
+    };
+    for(unsigned i=0;i<NUM_OF_BUFFERS;i++)
+        AlignedFree(D.ppBuffers[i]);
+    if (!Found)
+    {
+        Usage();
+        return 1;
+    };
+    return 0;
+};
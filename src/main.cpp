@@ -19,16 +19,19 @@
 
 #include "confuse.h"
 #include "misc.h"
+#include "arithmetic.h"
 #include "usecase.h"
+#include "workerpool.h"
 #include "array.h"
 #include "RAID5.h"
 #include "RTP.h"
 #ifndef STUDENTBUILD
 #include "RAID6.h"
-#include "Cauchy.h"
 #include "RDP.h"
 #endif
 #include "RS.h"
+#include "Cauchy.h"
+#include "LRC.h"
 
 //global configuration options
 
@@ -49,7 +52,8 @@ void Usage()
         "\t\t c  check array consistency\n"
         "\t\t b  run performance benchmarks ( l|r a|n WriteRatio BlockSize ThreadCount Duration )\n"
         "\t\t\t Access mode: l - linear, r - random\n"
-        "\t\t\t Access type: a - BlockSize aligned, n - non-aligned\n ";
+        "\t\t\t Access type: a - BlockSize aligned, n - non-aligned\n"
+        "\tThe TESTBED_ISA environment variable overrides the ISA configuration option\n ";
 };
 
 /**Report a configuration file problem
@@ -81,16 +85,29 @@ cfg_opt_t opts[] ={
     CFG_INT("DiskCapacity", 1024, CFGF_NONE),
     CFG_INT("MaxConcurrentThreads", 4, CFGF_NONE),
     CFG_STR("RAIDType", NULL, CFGF_NONE),
+    //instruction set for the arithmetic kernels (see pISANames). The best available one is used by default
+    CFG_STR("ISA", NULL, CFGF_NONE),
+    //CRC32C implementation (see pCRC32CNames). The best available one is used by default
+    CFG_STR("CRC32C", NULL, CFGF_NONE),
+    //the number of worker threads used to split the decoding of a single large stripe unit. 0 disables this
+    CFG_INT("DecodeWorkers", 0, CFGF_NONE),
+    //solve the RTP triple erasure equations by Gaussian elimination instead of the closed form
+    CFG_BOOL("GaussianTripleDecoding", cfg_false, CFGF_NONE),
+    //run both RTP triple erasure decoders and compare their results. Mismatches are reported as decoding failures
+    CFG_BOOL("CheckTripleDecoding", cfg_false, CFGF_NONE),
+    //count arithmetic and I/O operations (if compiled with OPERATION_COUNTING)
+    CFG_BOOL("OperationCounting", cfg_true, CFGF_NONE),
     CFG_SEC("disk", disk_opts, CFGF_MULTI),
     //all RAID types should be listed here
     PARAMCONFIG(RAID5),
 #ifndef STUDENTBUILD
     PARAMCONFIG(RAID6),
-    PARAMCONFIG(Cauchy),
     PARAMCONFIG(RDP),
 #endif
     PARAMCONFIG(RS),
     PARAMCONFIG(RTP),
+    PARAMCONFIG(Cauchy),
+    PARAMCONFIG(LRC),
     CFG_END()
 };
 char* pArrayStates[] = {"Uninitialized", "Failed", "Degraded", "Normal "};
@@ -139,6 +156,29 @@ int main(int argc, char **argv)
     unsigned DiskCapacity = cfg_getint(cfg, "DiskCapacity");
     unsigned NumOfDisks = cfg_size(cfg, "disk");
     unsigned MaxConcurrentThreads = cfg_getint(cfg, "MaxConcurrentThreads");
+    //select the arithmetic kernels
+    const char* pISA = getenv("TESTBED_ISA");
+    if (!pISA)
+        pISA = cfg_getstr(cfg, "ISA");
+    if (pISA && !SelectArithmeticISA(pISA))
+    {
+        cerr << "Instruction set " << pISA << " is unknown or not supported by this CPU\n";
+        return 1;
+    };
+    const char* pCRC32C = cfg_getstr(cfg, "CRC32C");
+    if (pCRC32C && !SelectCRC32C(pCRC32C))
+    {
+        cerr << "CRC32C implementation " << pCRC32C << " is unknown or not supported by this CPU\n";
+        return 1;
+    };
+    InitWorkerPool(cfg_getint(cfg, "DecodeWorkers"));
+    if (cfg_getbool(cfg, "CheckTripleDecoding"))
+        CRTPProcessor::SetTripleDecoding(CRTPProcessor::TripleDecoding::kSelfCheck);
+    else if (cfg_getbool(cfg, "GaussianTripleDecoding"))
+        CRTPProcessor::SetTripleDecoding(CRTPProcessor::TripleDecoding::kGaussian);
+#ifdef OPERATION_COUNTING
+    EnableOpCounting(cfg_getbool(cfg, "OperationCounting") > 0);
+#endif
     if (!NumOfDisks)
     {
         cerr << "No disk configuration found in the configuration file " << argv[1] << endl;
@@ -166,6 +206,7 @@ int main(int argc, char **argv)
         CDiskArray Array(NumOfDisks, pDisks, DiskCapacity, *pProcessor, MaxConcurrentThreads );
         cout << "Array type is " << ppRAIDNames[Array.GetType()] << '*'<<Array.GetNumOfSubarrays()<< endl;
         cout << "Array state is " << pArrayStates[Array.GetState()] << endl;
+        cout << "Arithmetic ISA is " << pISANames[GetArithmeticISA()] << endl;
         cout<<"Disk status ";
         for(unsigned i=0;i<Array.GetNumOfDisks();i++)
             cout<<Array.IsDiskOnline(i);
@@ -77,18 +77,52 @@ void GetTimes(double& UserTime,///user-mode process time
 
 };
 
-//counter for each operation
-volatile unsigned long long OPCount[opEnd]={0,0,0,0,0};
+#ifdef OPERATION_COUNTING
 //human-readable names for each operation
 const char* pOpNames[opEnd]={"XOR","Multiply","Multiply-XOR","Read","Write"};
+//operation counting switch
+bool OpCountingEnabled=true;
+//the list of counter shards of all threads which have ever performed an operation
+static std::atomic<OpCountShard*> pOpCountShards(0);
+
+///allocate a shard for the current thread and add it to the list.
+///The shards are never released, so that the operations of terminated threads are still accounted
+OpCountShard* RegisterOpCountShard()
+{
+    OpCountShard* pShard=new OpCountShard;
+    for(unsigned i=0;i<opEnd;i++)
+        pShard->Count[i].store(0,std::memory_order_relaxed);
+    pShard->pNext=pOpCountShards.load();
+    while(!pOpCountShards.compare_exchange_weak(pShard->pNext,pShard));
+    pOpCountShard=pShard;
+    return pShard;
+};
 
 //reset operation counters
 bool ResetOpCount()
 {
-    memset((void*)OPCount,0,sizeof(OPCount));
+    for(OpCountShard* pShard=pOpCountShards.load();pShard;pShard=pShard->pNext)
+        for(unsigned i=0;i<opEnd;i++)
+            pShard->Count[i].store(0,std::memory_order_relaxed);
     return true;
 };
 
-//force counter reset at program startup
-bool Reset=ResetOpCount();
+//sum up the counters of all threads
+unsigned long long GetOpCount(eOperations Type)
+{
+    unsigned long long S=0;
+    for(OpCountShard* pShard=pOpCountShards.load();pShard;pShard=pShard->pNext)
+        S+=pShard->Count[Type].load(std::memory_order_relaxed);
+    return S;
+};
+
+void EnableOpCounting(bool Enable)
+{
+    OpCountingEnabled=Enable;
+};
 
+bool IsOpCountingEnabled()
+{
+    return OpCountingEnabled;
+};
+#endif
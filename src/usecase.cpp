@@ -30,6 +30,21 @@
 
 using namespace std;
 
+///print the number of operations per byte of payload data and reset the counters
+static void ReportOpCount(double Size///the amount of payload data processed
+                         )
+{
+#ifdef OPERATION_COUNTING
+    if (!IsOpCountingEnabled())
+        return;
+    cout<<"Operations per byte: ";
+    for(unsigned i=0;i<opEnd;i++)
+        cout<<pOpNames[i]<<'('<<double(GetOpCount(eOperations(i)))/Size<<") ";
+    cout<<endl;
+    ResetOpCount();
+#endif
+};
+
 int InitializeArray(CDiskArray& A)
 {
 
@@ -95,13 +110,7 @@ int IntegerReadVerify(CDiskArray& A, ///the array to be inspected
     };
     GetTimes(StopTime,Dummy,Dummy);
     cout<<"Write throughput "<<Size/(StopTime-StartTime)<<" bytes/s"<<endl;
-#ifdef OPERATION_COUNTING
-    cout<<"Operations per byte: ";
-    for(unsigned i=0;i<opEnd;i++)
-        cout<<pOpNames[i]<<'('<<double(OPCount[i])/Size<<") ";
-    cout<<endl;
-    ResetOpCount();
-#endif
+    ReportOpCount(Size);
     StartTime=StopTime;
     if (!A.Check())
     {
@@ -109,13 +118,7 @@ int IntegerReadVerify(CDiskArray& A, ///the array to be inspected
     };
     GetTimes(StopTime,Dummy,Dummy);
     cout<<"Check throughput "<<Size/(StopTime-StartTime)<<" bytes/s"<<endl;
-#ifdef OPERATION_COUNTING
-    cout<<"Operations per byte: ";
-    for(unsigned i=0;i<opEnd;i++)
-        cout<<pOpNames[i]<<'('<<double(OPCount[i])/Size<<") ";
-    cout<<endl;
-    ResetOpCount();
-#endif
+    ReportOpCount(Size);
 
     memset(pData.get(), 0xff, Size);
     A.seek(F, 0, SEEK_SET);
@@ -141,13 +144,7 @@ int IntegerReadVerify(CDiskArray& A, ///the array to be inspected
     };
     GetTimes(StopTime,Dummy,Dummy);
     cout<<"Read throughput "<<Size/(StopTime-StartTime)<<" bytes/s"<<endl;
-#ifdef OPERATION_COUNTING
-    cout<<"Operations per byte: ";
-    for(unsigned i=0;i<opEnd;i++)
-        cout<<pOpNames[i]<<'('<<double(OPCount[i])/Size<<") ";
-    cout<<endl;
-    ResetOpCount();
-#endif
+    ReportOpCount(Size);
     //make sure read was correct
     for (unsigned i = 0; i < CounterSize; i++)
         if (pData[i] != i+offset)
@@ -167,12 +164,15 @@ struct FileHeader
 {
     ///file size
     off64_t Size;
-    ///CRC32 checksum
+    ///CRC32C checksum, or legacy CRC32 checksum for headers written by older versions
     unsigned CRC32;
-    ///header checksum
+    ///header checksum. It is Size^CRC32^CRC32C_HEADER_TAG for CRC32C headers, and Size^CRC32 for legacy ones
     off64_t Checksum;
 };
 
+///distinguishes headers containing CRC32C from the legacy ones
+#define CRC32C_HEADER_TAG 0x4352433332430001ll
+
 /** store file size, CRC checksum and payload data in the array
  */
 int StoreFile(CDiskArray& A, ///the array to be used
@@ -200,10 +200,9 @@ int StoreFile(CDiskArray& A, ///the array to be used
     close(File);
     FileHeader Header;
     Header.Size = FileSize;
-    InitCRC32();
     Header.CRC32 = 0;
-    UpdateCRC32(Header.CRC32, FileSize, pData.get());
-    Header.Checksum = Header.Size^Header.CRC32;
+    UpdateCRC32C(Header.CRC32, FileSize, pData.get());
+    Header.Checksum = Header.Size^Header.CRC32^CRC32C_HEADER_TAG;
 
 
     CDiskArray::tHandle F = A.open();
@@ -222,13 +221,7 @@ int StoreFile(CDiskArray& A, ///the array to be used
     };
     GetTimes(StopTime,Dummy,Dummy);
     cerr << "File stored successfully\n";
-#ifdef OPERATION_COUNTING
-    cout<<"Operations per byte: ";
-    for(unsigned i=0;i<opEnd;i++)
-        cout<<pOpNames[i]<<'('<<double(OPCount[i])/FileSize<<") ";
-    cout<<endl;
-    ResetOpCount();
-#endif
+    ReportOpCount(FileSize);
     return 0;
 };
 
@@ -249,7 +242,8 @@ int ReadFile(CDiskArray& A, ///the array to be used
         cerr << "Failed to read file header from the array\n";
         return 3;
     };
-    if ((Header.Size^Header.CRC32) != Header.Checksum)
+    bool Legacy = (Header.Size^Header.CRC32) == Header.Checksum;
+    if (!Legacy && ((Header.Size^Header.CRC32^CRC32C_HEADER_TAG) != Header.Checksum))
     {
         cerr << "Invalid file header\n";
         return 3;
@@ -265,9 +259,14 @@ int ReadFile(CDiskArray& A, ///the array to be used
         return 3;
     };
     GetTimes(StopTime,Dummy,Dummy);
-    InitCRC32();
     unsigned CRC32 = 0;
-    UpdateCRC32(CRC32, Header.Size, pData.get());
+    if (Legacy)
+    {
+        InitCRC32();
+        UpdateCRC32(CRC32, Header.Size, pData.get());
+    }
+    else
+        UpdateCRC32C(CRC32, Header.Size, pData.get());
     if (CRC32 != Header.CRC32)
     {
         cerr << "File checksum mismatch\n";
@@ -285,13 +284,7 @@ int ReadFile(CDiskArray& A, ///the array to be used
         return 3;
     };
     cerr << "File extracted successfully\n";
-#ifdef OPERATION_COUNTING
-    cout<<"Operations per byte: ";
-    for(unsigned i=0;i<opEnd;i++)
-        cout<<pOpNames[i]<<'('<<double(OPCount[i])/Header.Size<<") ";
-    cout<<endl;
-    ResetOpCount();
-#endif
+    ReportOpCount(Header.Size);
     return 0;
 };
 
@@ -0,0 +1,133 @@
+/*********************************************************
+ * workerpool.cpp  - implementation of a pool of worker threads
+ *
+ * Copyright(C) 2012 Saint-Petersburg State Polytechnic University
+ *
+ * Developed in the framework of the "Forward error correction for next generation storage systems" project
+ *
+ * Author: P. Trifonov petert@dcn.ftk.spbstu.ru
+ * ********************************************************/
+
+#include <memory>
+#include "workerpool.h"
+#include "misc.h"
+
+/**
+ * Initialize the synchronization objects and spawn the workers
+ */
+CWorkerPool::CWorkerPool(unsigned NumOfWorkers ///the number of threads to spawn
+        ) : m_pQueueHead(0), m_pQueueTail(0), m_Shutdown(false)
+{
+    if (!InitCS(m_Mutex))
+        throw Exception("Worker pool mutex initialization failed");
+    if (!InitCond(m_WorkAvailable) || !InitCond(m_JobDone))
+        throw Exception("Worker pool condition initialization failed");
+    m_Workers.reserve(NumOfWorkers);
+    for (unsigned i = 0; i < NumOfWorkers; i++)
+        m_Workers.emplace_back(&CWorkerPool::WorkerLoop, this);
+};
+
+/**
+ * Stop the workers. No jobs may be running at this point
+ */
+CWorkerPool::~CWorkerPool()
+{
+    LockCS(m_Mutex);
+    m_Shutdown = true;
+    CondWakeAll(m_WorkAvailable);
+    UnlockCS(m_Mutex);
+    for (std::thread& T : m_Workers)
+        T.join();
+    DestroyCond(m_JobDone);
+    DestroyCond(m_WorkAvailable);
+    DestroyCS(m_Mutex);
+};
+
+unsigned CWorkerPool::TakeTask(Job* pJob)
+{
+    unsigned TaskID = pJob->NextTask++;
+    if (pJob->NextTask == pJob->NumOfTasks)
+    {
+        //the queue is short, since each processing thread has at most one job
+        Job** ppPrev = &m_pQueueHead;
+        Job* pPrev = 0;
+        while (*ppPrev != pJob)
+        {
+            pPrev = *ppPrev;
+            ppPrev = &pPrev->pNext;
+        };
+        *ppPrev = pJob->pNext;
+        if (m_pQueueTail == pJob)
+            m_pQueueTail = pPrev;
+    };
+    return TaskID;
+};
+
+void CWorkerPool::Execute(Job* pJob, unsigned TaskID)
+{
+    UnlockCS(m_Mutex);
+    (*pJob->pTask)(TaskID);
+    LockCS(m_Mutex);
+    if (!--pJob->Pending)
+        CondWakeAll(m_JobDone);
+};
+
+void CWorkerPool::WorkerLoop()
+{
+    LockCS(m_Mutex);
+    for (;;)
+    {
+        while (!m_Shutdown && !m_pQueueHead)
+            CondWait(m_WorkAvailable, m_Mutex);
+        if (m_Shutdown)
+            break;
+        Job* pJob = m_pQueueHead;
+        Execute(pJob, TakeTask(pJob));
+    };
+    UnlockCS(m_Mutex);
+};
+
+/**
+ * Queue the tasks for the workers, and execute them in the calling thread too,
+ * until all of them are started. Then wait for the ones taken by the workers.
+ */
+void CWorkerPool::Run(unsigned NumOfTasks, ///the number of tasks
+                      const std::function<void(unsigned)>& Task ///the task body
+        )
+{
+    if (!NumOfTasks)
+        return;
+    if (NumOfTasks == 1 || m_Workers.empty())
+    {
+        for (unsigned i = 0; i < NumOfTasks; i++)
+            Task(i);
+        return;
+    };
+    Job J = {&Task, NumOfTasks, 0, NumOfTasks, 0};
+    LockCS(m_Mutex);
+    if (m_pQueueTail)
+        m_pQueueTail->pNext = &J;
+    else
+        m_pQueueHead = &J;
+    m_pQueueTail = &J;
+    CondWakeAll(m_WorkAvailable);
+    while (J.NextTask < J.NumOfTasks)
+        Execute(&J, TakeTask(&J));
+    while (J.Pending)
+        CondWait(m_JobDone, m_Mutex);
+    UnlockCS(m_Mutex);
+};
+
+//the pool shared by all processors
+static std::unique_ptr<CWorkerPool> pWorkerPool;
+
+void InitWorkerPool(unsigned NumOfWorkers ///the number of worker threads. 0 disables the pool
+        )
+{
+    pWorkerPool.reset(NumOfWorkers ? new CWorkerPool(NumOfWorkers) : 0);
+};
+
+CWorkerPool* GetWorkerPool()
+{
+    return pWorkerPool.get();
+};